@@ -0,0 +1,85 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__BATCH_EVALUATOR_HPP_
+#define GANKENKUN__COM__BATCH_EVALUATOR_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+
+namespace gankenkun
+{
+
+// Evaluates candidate footstep sequences on a fixed pool of worker threads
+class BatchEvaluator
+{
+public:
+  using FootSteps = std::deque<FootStepPlanner::FootStep>;
+  using Evaluation = CenterOfMassGenerator::Evaluation;
+  using State = CenterOfMassGenerator::State;
+
+  // Zero threads uses every hardware thread, the calling thread always takes part
+  explicit BatchEvaluator(size_t threads = 0);
+  ~BatchEvaluator();
+
+  BatchEvaluator(const BatchEvaluator &) = delete;
+  BatchEvaluator & operator=(const BatchEvaluator &) = delete;
+
+  // Results keep the order of the candidates
+  std::vector<Evaluation> evaluate(
+    const CenterOfMassGenerator & generator, const std::vector<FootSteps> & candidates,
+    const State & start);
+
+  size_t get_threads() const { return workers.size() + 1; }
+
+private:
+  void work();
+  void run_job();
+
+  std::vector<std::thread> workers;
+
+  std::mutex batch_mutex;
+
+  std::mutex mutex;
+  std::condition_variable wake_condition;
+  std::condition_variable done_condition;
+  size_t generation;
+  size_t active_workers;
+  bool stopping;
+
+  // Current job, only written while no worker is active
+  const CenterOfMassGenerator * generator;
+  const std::vector<FootSteps> * candidates;
+  const State * start;
+  std::vector<Evaluation> * results;
+  size_t job_size;
+  std::atomic<size_t> next_index;
+  std::atomic<size_t> finished;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__BATCH_EVALUATOR_HPP_
@@ -0,0 +1,127 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__CENTER_OF_MASS_GENERATOR_HPP_
+#define GANKENKUN__COM__CENTER_OF_MASS_GENERATOR_HPP_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "gankenkun/walking/planner/foot_step_planner.hpp"
+#include "keisan/geometry/point_2.hpp"
+
+namespace gankenkun
+{
+
+// Produces the COM trajectory of the walking loop one control tick at a time
+class CenterOfMassGenerator
+{
+public:
+  struct COMTrajectory
+  {
+    keisan::Point2 position;
+    keisan::Point2 velocity;
+    keisan::Point2 projected_position;
+  };
+
+  // COM over a span of time as a cubic in the time since its start plus two exponentials
+  struct Segment
+  {
+    double start_time = 0.0;
+    double duration = 0.0;
+    double omega = 0.0;
+    keisan::Point2 coefficients[4];  // Constant, linear, quadratic and cubic terms
+    keisan::Point2 growth;  // Scales e^(omega t)
+    keisan::Point2 decay;  // Scales e^(-omega t)
+
+    double get_end_time() const { return start_time + duration; }
+
+    keisan::Point2 get_position(double time) const;
+    keisan::Point2 get_velocity(double time) const;
+  };
+
+  // Full model state, the meaning of the control depends on the generator
+  struct State
+  {
+    keisan::Point2 position;
+    keisan::Point2 velocity;
+    keisan::Point2 acceleration;
+    keisan::Point2 control;
+  };
+
+  // Result of running a whole footstep sequence, the ZMP error is measured against the support foot
+  struct Evaluation
+  {
+    std::vector<COMTrajectory> com_trajectory;
+    State final_state;
+    double max_zmp_error = 0.0;
+    double rms_zmp_error = 0.0;
+    double final_com_error = 0.0;
+  };
+
+  virtual ~CenterOfMassGenerator() {}
+
+  // Copy with the same model and streaming state, for evaluating on another thread
+  virtual std::unique_ptr<CenterOfMassGenerator> clone() const = 0;
+
+  // Start the step that begins at the given tick, the front footstep is the support one
+  virtual void begin(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset = false) = 0;
+  virtual COMTrajectory advance(const std::deque<FootStepPlanner::FootStep> & foot_steps) = 0;
+
+  // Footsteps from the given index on were replaced mid-step, the step itself keeps streaming
+  virtual void update_steps(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed) = 0;
+
+  // Count a sample produced elsewhere, the state has to be restored with set_state() afterwards
+  virtual void skip_sample(const COMTrajectory & com) = 0;
+  virtual int get_remaining_samples() const = 0;
+
+  virtual bool is_settled(double tolerance = 1e-4) const = 0;
+
+  virtual State get_state() const = 0;
+  virtual void set_state(const State & state) = 0;
+
+  // The state relative to an origin and back, positions kept in the control move along
+  virtual State to_local(const State & state, const keisan::Point2 & origin) const;
+  virtual State to_world(const State & state, const keisan::Point2 & origin) const;
+
+  // Reentrant, leaves the streaming state untouched
+  virtual Evaluation evaluate(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const = 0;
+
+  // Number of footsteps after the support one that shape the current step
+  virtual size_t get_window_size() const = 0;
+
+  // Closed form of the whole current step, false for generators that change the jerk every sample
+  // and so have no closed form shorter than a sample
+  virtual bool get_segment(Segment & /* segment */) const { return false; }
+
+protected:
+  // Stream every step of the sequence through the given copy, the way the walking loop does
+  static Evaluation simulate(
+    CenterOfMassGenerator & generator, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    const State & start);
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__CENTER_OF_MASS_GENERATOR_HPP_
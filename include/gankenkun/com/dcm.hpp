@@ -0,0 +1,91 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__DCM_HPP_
+#define GANKENKUN__COM__DCM_HPP_
+
+#include <deque>
+#include <memory>
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "keisan/geometry/point_2.hpp"
+
+namespace gankenkun
+{
+
+// Closed-form COM from the divergent component of motion, constant ZMP within a step
+class DCM : public CenterOfMassGenerator
+{
+public:
+  DCM();
+
+  std::unique_ptr<CenterOfMassGenerator> clone() const override;
+
+  void set_parameters(double z, double dt);
+
+  void begin(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    bool reset = false) override;
+  COMTrajectory advance(const std::deque<FootStepPlanner::FootStep> & foot_steps) override;
+  void update_steps(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed) override;
+
+  void skip_sample(const COMTrajectory & com) override;
+  int get_remaining_samples() const override { return samples - sample; }
+
+  bool is_settled(double tolerance = 1e-4) const override;
+
+  // The whole step is one segment
+  bool get_segment(Segment & segment) const override;
+
+  // The control of the state is the ZMP of the current step
+  State get_state() const override;
+  void set_state(const State & state) override;
+  State to_local(const State & state, const keisan::Point2 & origin) const override;
+  State to_world(const State & state, const keisan::Point2 & origin) const override;
+
+  Evaluation evaluate(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const override;
+
+  size_t get_window_size() const override { return window_size; }
+
+  double z;
+  double dt;
+
+private:
+  double omega;
+
+  // COM of the current step is zmp + decay * e^(-omega * t) + growth * e^(omega * t)
+  keisan::Point2 zmp;
+  keisan::Point2 decay;
+  keisan::Point2 growth;
+
+  keisan::Point2 position;
+  keisan::Point2 velocity;
+
+  int start_tick;
+  int sample;
+  int samples;
+  size_t window_size;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__DCM_HPP_
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__MPC_HPP_
+#define GANKENKUN__COM__MPC_HPP_
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "gankenkun/com/qp_solver.hpp"
+#include "keisan/matrix.hpp"
+
+namespace gankenkun
+{
+
+// Linear MPC over the LIPM jerk model, the ZMP is kept inside a box around the support foot
+class MPC : public CenterOfMassGenerator
+{
+public:
+  // Both axes of the last tick together
+  struct SolverReport
+  {
+    int iterations = 0;
+    double duration = 0.0;
+    int active_constraints = 0;
+    bool converged = false;
+  };
+
+  MPC();
+
+  std::unique_ptr<CenterOfMassGenerator> clone() const override;
+
+  void set_parameters(double z, double dt, double period);
+
+  // Iteration budget of an axis and time budget of a tick, a non-positive duration disables the
+  // deadline
+  void set_solver(int max_iterations, double max_duration);
+
+  // Half size of the ZMP box around the reference
+  void set_zmp_margin(double margin) { zmp_margin = margin; }
+
+  const SolverReport & get_solver_report() const { return solver_report; }
+
+  void begin(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    bool reset = false) override;
+  COMTrajectory advance(const std::deque<FootStepPlanner::FootStep> & foot_steps) override;
+  void update_steps(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed) override;
+
+  void skip_sample(const COMTrajectory & com) override;
+  int get_remaining_samples() const override { return samples - sample; }
+
+  bool is_settled(double tolerance = 1e-4) const override;
+
+  // The control of the state is the last jerk input
+  State get_state() const override;
+  void set_state(const State & state) override;
+
+  Evaluation evaluate(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const override;
+
+  size_t get_window_size() const override { return window_size; }
+
+  double z;
+  double dt;
+  double period;
+
+private:
+  keisan::Matrix<3, 3> A_d;
+  keisan::Matrix<3, 1> B_d;
+  keisan::Matrix<1, 3> C_d;
+
+  int horizon;
+
+  // Predicted ZMP of the horizon from the initial state and from the inputs
+  std::vector<double> zmp_state;
+  std::vector<double> zmp_input;
+
+  QPSolver solver;
+  QPSolver::Solution solutions[2];
+
+  int max_iterations;
+  double max_duration;
+  double zmp_margin;
+  SolverReport solver_report;
+
+  // Per axis position, velocity and acceleration
+  double state[3][2];
+  double control[2];
+
+  int start_tick;
+  int sample;
+  int samples;
+  size_t window_size;
+
+  std::vector<double> reference;
+  std::vector<double> gradient;
+  std::vector<double> lower;
+  std::vector<double> upper;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__MPC_HPP_
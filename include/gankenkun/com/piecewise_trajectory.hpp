@@ -0,0 +1,72 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__PIECEWISE_TRAJECTORY_HPP_
+#define GANKENKUN__COM__PIECEWISE_TRAJECTORY_HPP_
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "gankenkun/utils/ring_buffer.hpp"
+#include "keisan/geometry/point_2.hpp"
+
+namespace gankenkun
+{
+
+// COM segments back to back in time, queryable at any timestamp they cover, one entry per step
+// apart from the ones merged while the COM is at rest
+class PiecewiseTrajectory
+{
+public:
+  using Segment = CenterOfMassGenerator::Segment;
+
+  PiecewiseTrajectory();
+
+  // A segment that the last one already reproduces within the tolerance only extends it
+  void set_tolerance(double tolerance) { this->tolerance = tolerance; }
+
+  // The oldest segments are dropped beyond this count
+  void set_capacity(size_t capacity);
+
+  // Segments starting at or after the new one are replaced by it
+  void append(const Segment & segment);
+  void clear() { segments.clear(); }
+
+  // False when the time is outside of the covered span
+  bool get_position(double time, keisan::Point2 & position) const;
+  bool get_velocity(double time, keisan::Point2 & velocity) const;
+
+  bool empty() const { return segments.empty(); }
+  size_t size() const { return segments.size(); }
+  const Segment & operator[](size_t index) const { return segments[index]; }
+
+  double get_start_time() const { return segments.front().start_time; }
+  double get_end_time() const { return segments.back().get_end_time(); }
+
+private:
+  const Segment * find(double time) const;
+  bool is_continued(const Segment & segment) const;
+
+  RingBuffer<Segment> segments;
+  size_t capacity;
+  double tolerance;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__PIECEWISE_TRAJECTORY_HPP_
@@ -0,0 +1,105 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__COM__QP_SOLVER_HPP_
+#define GANKENKUN__COM__QP_SOLVER_HPP_
+
+#include <chrono>
+#include <vector>
+
+namespace gankenkun
+{
+
+// Dense ADMM solver for min 1/2 x' H x + g' x subject to lower <= A x <= upper,
+// H and A stay fixed so their factorization is done once and only g and the bounds change
+class QPSolver
+{
+public:
+  // Iterates kept between solves to warm start the next one
+  struct Solution
+  {
+    std::vector<double> x;  // Primal
+    std::vector<double> z;  // Constraint value
+    std::vector<double> y;  // Dual
+  };
+
+  struct Report
+  {
+    int iterations = 0;
+    double duration = 0.0;
+    double primal_residual = 0.0;
+    double dual_residual = 0.0;
+    int active_constraints = 0;
+    bool converged = false;
+  };
+
+  QPSolver();
+
+  // Matrices are row-major, false when H is not positive semidefinite
+  bool set_problem(
+    const std::vector<double> & hessian, const std::vector<double> & constraints, size_t variables,
+    size_t rows);
+
+  // The step size is part of the factorization, it applies from the next set_problem()
+  void set_step_size(double rho) { this->rho = rho; }
+  void set_tolerance(double tolerance) { this->tolerance = tolerance; }
+
+  // Stops at the iteration limit or the deadline, whichever comes first, only a cold start
+  // allocates
+  Report solve(
+    const std::vector<double> & gradient, const std::vector<double> & lower,
+    const std::vector<double> & upper, Solution & solution, int max_iterations,
+    const std::chrono::steady_clock::time_point & deadline);
+
+  // Move a receding horizon solution one stage ahead, repeating the last stage
+  static void shift(Solution & solution);
+
+  size_t get_variables() const { return variables; }
+  size_t get_rows() const { return rows; }
+
+private:
+  void multiply(const std::vector<double> & x, std::vector<double> & result) const;
+  void multiply_transpose(const std::vector<double> & z, std::vector<double> & result) const;
+  void substitute(std::vector<double> & x) const;
+
+  size_t variables;
+  size_t rows;
+
+  double rho;
+  double sigma;
+  double tolerance;
+
+  std::vector<double> constraints;
+  std::vector<size_t> row_begin;
+  std::vector<size_t> row_end;
+
+  // Cholesky factor of H + sigma I + rho A' A
+  std::vector<double> factor;
+
+  // Workspace of an iteration, sized with the problem
+  std::vector<double> rhs;
+  std::vector<double> ax;
+  std::vector<double> dz;
+  std::vector<double> dual;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__COM__QP_SOLVER_HPP_
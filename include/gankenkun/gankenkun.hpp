@@ -21,6 +21,13 @@
 #ifndef GANKENKUN__GANKENKUN_HPP_
 #define GANKENKUN__GANKENKUN_HPP_
 
+#include "gankenkun/com/batch_evaluator.hpp"
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "gankenkun/com/dcm.hpp"
+#include "gankenkun/com/mpc.hpp"
+#include "gankenkun/com/piecewise_trajectory.hpp"
+#include "gankenkun/com/qp_solver.hpp"
+#include "gankenkun/lipm/gain_bank.hpp"
 #include "gankenkun/lipm/lipm.hpp"
 #include "gankenkun/node/gankenkun_node.hpp"
 #include "gankenkun/walking/walking.hpp"
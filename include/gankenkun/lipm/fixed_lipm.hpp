@@ -0,0 +1,217 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__LIPM__FIXED_LIPM_HPP_
+#define GANKENKUN__LIPM__FIXED_LIPM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <ratio>
+#include <vector>
+
+#include "gankenkun/lipm/lipm.hpp"
+
+namespace gankenkun
+{
+
+// Input matrix of the discretized cart-table model, the same quadrature as LIPM::discretize()
+constexpr std::array<double, 3> discretize_input(double dt)
+{
+  std::array<double, 3> b = {0.0, 0.0, 0.0};
+
+  for (size_t i = 0; i < 10; ++i) {
+    double tau = dt * (i + 0.5) / 10;
+    b[0] += tau * tau / 2 * dt / 10;
+    b[1] += tau * dt / 10;
+    b[2] += dt / 10;
+  }
+
+  return b;
+}
+
+// Position, velocity and acceleration of the COM under a jerk input, discretized at compile time,
+// only the ZMP projection and the gains depend on the COM height
+template <typename TimeStep>
+struct FixedLIPMModel
+{
+  static constexpr double dt = static_cast<double>(TimeStep::num) / TimeStep::den;
+
+  static constexpr std::array<std::array<double, 3>, 3> a = {
+    {{1.0, dt, dt * dt / 2}, {0.0, 1.0, dt}, {0.0, 0.0, 1.0}}};
+  static constexpr std::array<double, 3> b = discretize_input(dt);
+};
+
+// LIPM specialized for a compile-time time step (as a std::ratio of seconds) and preview horizon
+template <typename TimeStep, size_t Horizon>
+class FixedLIPM : public LIPM
+{
+public:
+  using Model = FixedLIPMModel<TimeStep>;
+
+  static constexpr double time_step = Model::dt;
+  static constexpr int horizon = static_cast<int>(Horizon);
+
+  static bool is_matching(double dt, double period)
+  {
+    return std::abs(dt - time_step) < 1e-9 && std::lround(period / time_step) == horizon;
+  }
+
+  FixedLIPM() : next_transition(0), last_slot(-1), stale(true)
+  {
+    fixed_f.fill(0.0);
+    references.fill({0.0, 0.0});
+  }
+
+  std::unique_ptr<CenterOfMassGenerator> clone() const override
+  {
+    return std::make_unique<FixedLIPM>(*this);
+  }
+
+  void begin(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    bool reset = false) override
+  {
+    LIPM::begin(tick, foot_steps, reset);
+    fill_references(foot_steps);
+  }
+
+  // The single precision kernel keeps the runtime path
+  COMTrajectory advance(const std::deque<FootStepPlanner::FootStep> & foot_steps) override
+  {
+    if (single_precision) {
+      return LIPM::advance(foot_steps);
+    }
+
+    if (stale) {
+      fill_references(foot_steps);
+    }
+
+    const double reference[2] = {foot_steps.front().position.x, foot_steps.front().position.y};
+    double projected[2];
+    double control[2];
+
+    kernel.feedback(reference, projected, control);
+
+    // Window of ZMP reference changes from this sample on, contiguous in the mirrored storage
+    const auto * window = references.data() + sample % Horizon;
+    for (size_t j = 0; j < Horizon; ++j) {
+      control[0] += fixed_f[j] * window[j][0];
+      control[1] += fixed_f[j] * window[j][1];
+    }
+
+    kernel.template integrate<Model>(control);
+
+    auto com = COMTrajectory();
+
+    com.position.x = kernel.get_position(0);
+    com.position.y = kernel.get_position(1);
+    com.velocity.x = kernel.get_velocity(0);
+    com.velocity.y = kernel.get_velocity(1);
+    com.projected_position.x = projected[0];
+    com.projected_position.y = projected[1];
+
+    // This sample leaves the window and the one a horizon ahead enters it
+    set_reference(sample + horizon, foot_steps);
+    sample++;
+
+    return com;
+  }
+
+  void update_steps(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed) override
+  {
+    LIPM::update_steps(foot_steps, first_changed);
+    fill_references(foot_steps);
+  }
+
+  // Without the footsteps the window can not be shifted, it is rebuilt on the next advance()
+  void skip_sample(const COMTrajectory & com) override
+  {
+    LIPM::skip_sample(com);
+    stale = true;
+  }
+
+protected:
+  // Truncated gains are zero padded so the preview loop keeps its fixed trip count
+  void store_gains() override
+  {
+    fixed_f.fill(0.0);
+    std::copy_n(f.begin(), std::min(f.size(), Horizon), fixed_f.begin());
+  }
+
+private:
+  // Place the ZMP reference changes of the samples inside the horizon from the current one
+  void fill_references(const std::deque<FootStepPlanner::FootStep> & foot_steps)
+  {
+    next_transition = 0;
+    last_slot = -1;
+
+    while (next_transition < preview_ticks.size() && get_slot() < sample) {
+      last_slot = get_slot();
+      next_transition++;
+    }
+
+    for (int offset = sample; offset < sample + horizon; ++offset) {
+      set_reference(offset, foot_steps);
+    }
+
+    stale = false;
+  }
+
+  // Transitions sharing a tick go to consecutive samples, the way LIPM::add_preview() spreads them
+  int get_slot() const { return std::max(preview_ticks[next_transition], last_slot + 1); }
+
+  void set_reference(int offset, const std::deque<FootStepPlanner::FootStep> & foot_steps)
+  {
+    std::array<double, 2> reference = {0.0, 0.0};
+
+    if (next_transition < preview_ticks.size() && get_slot() == offset) {
+      const auto & from = foot_steps[next_transition].position;
+      const auto & to = foot_steps[next_transition + 1].position;
+
+      reference = {to.x - from.x, to.y - from.y};
+
+      last_slot = offset;
+      next_transition++;
+    }
+
+    size_t index = offset % Horizon;
+    references[index] = reference;
+    references[index + Horizon] = reference;
+  }
+
+  std::array<double, Horizon> fixed_f;
+
+  // Each reference change is stored twice so any window of Horizon samples is contiguous
+  std::array<std::array<double, 2>, Horizon * 2> references;
+  size_t next_transition;
+  int last_slot;
+  bool stale;
+};
+
+// Pick a compiled-in profile matching the parameters, or fall back to the runtime LIPM
+std::unique_ptr<LIPM> make_lipm(double dt, double period);
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__LIPM__FIXED_LIPM_HPP_
@@ -0,0 +1,89 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__LIPM__GAIN_BANK_HPP_
+#define GANKENKUN__LIPM__GAIN_BANK_HPP_
+
+#include <string>
+#include <vector>
+
+#include "keisan/matrix.hpp"
+
+namespace gankenkun
+{
+
+// Precomputed LIPM gains over a grid of COM heights and preview periods at a single time step
+class GainBank
+{
+public:
+  struct Gains
+  {
+    keisan::Matrix<1, 4> F = keisan::Matrix<1, 4>::zero();  // Feedback gain
+    std::vector<double> f;                                   // Preview gain
+  };
+
+  GainBank();
+
+  // Same meaning as LIPM::set_solver(), applied to every grid point
+  void set_solver(int solver, int max_iterations, double max_duration);
+
+  // Solve the DARE for every grid point, meant to run offline
+  void generate(
+    double time_step, const std::vector<double> & com_heights,
+    const std::vector<double> & com_periods, double preview_threshold);
+
+  bool load(const std::string & path);
+  bool save(const std::string & path) const;
+
+  bool empty() const { return gains.empty(); }
+  double get_time_step() const { return time_step; }
+  double get_preview_threshold() const { return preview_threshold; }
+
+  // Longest preview period of the grid, zero for an empty bank
+  double get_max_period() const { return com_periods.empty() ? 0.0 : com_periods.back(); }
+
+  // Bilinear blend of the four surrounding grid points, false outside the grid
+  bool interpolate(double com_height, double com_period, Gains & result) const;
+
+private:
+  static bool is_increasing(const std::vector<double> & axis);
+  static bool find_cell(
+    const std::vector<double> & axis, double value, size_t & index, double & fraction);
+
+  const Gains & get_gains(size_t height_index, size_t period_index) const;
+
+  double time_step;
+  double preview_threshold;
+
+  // DARE solver
+  int solver;
+  int max_iterations;
+  double max_duration;
+
+  std::vector<double> com_heights;
+  std::vector<double> com_periods;
+
+  // Row-major, one row of periods per COM height
+  std::vector<Gains> gains;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__LIPM__GAIN_BANK_HPP_
@@ -21,57 +21,176 @@
 #ifndef GANKENKUN__LIPM__LIPM_HPP_
 #define GANKENKUN__LIPM__LIPM_HPP_
 
+#include <chrono>
 #include <deque>
-
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "gankenkun/lipm/gain_bank.hpp"
+#include "gankenkun/lipm/lipm_kernel.hpp"
+#include "gankenkun/utils/ring_buffer.hpp"
 #include "gankenkun/walking/planner/foot_step_planner.hpp"
 #include "keisan/matrix.hpp"
 
 namespace gankenkun
 {
 
-class LIPM
+class LIPM : public CenterOfMassGenerator
 {
 public:
+  enum { ITERATIVE_SOLVER = 0, DOUBLING_SOLVER = 1 };
+
+  struct DAREReport
+  {
+    int iterations = 0;
+    double residual = 0.0;
+    double duration = 0.0;
+    bool converged = false;
+  };
+
   LIPM();
-  ~LIPM() {}
+  virtual ~LIPM() {}
+
+  std::unique_ptr<CenterOfMassGenerator> clone() const override;
 
   void initialize();
   void solve_dare();
 
+  static void discretize(
+    double z, double dt, keisan::Matrix<3, 3> & A_d, keisan::Matrix<3, 1> & B_d,
+    keisan::Matrix<1, 3> & C_d);
+
+  // Batch form of begin() and advance() for offline use, the walking loop streams instead
   void update(
-    double time, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset = false);
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset = false);
 
-  void set_parameters(double z, double dt, double period);
+  void set_parameters(double z, double dt, double period, double max_step_duration);
+
+  // Iteration and time budget of the DARE solver, a non-positive duration disables the deadline
+  void set_solver(int solver, int max_iterations, double max_duration);
+  const DAREReport & get_dare_report() const { return dare_report; }
+
+  // Preview gains below this fraction of the first one are truncated, zero keeps the full horizon
+  void set_preview_threshold(double threshold);
+  int get_preview_length() const { return static_cast<int>(f.size()); }
+
+  const keisan::Matrix<1, 4> & get_feedback_gain() const { return F; }
+  const std::vector<double> & get_preview_gain() const { return f; }
+
+  // Swap in precomputed gains for another COM height and period, only between steps
+  void set_gains(double z, double period, const GainBank::Gains & gains);
+
+  // Run the per-sample state update in float instead of double
+  void set_single_precision(bool single_precision);
+
+  // Converged gains are reused from this file when the model parameters match
+  void set_gain_cache(const std::string & path) { gain_cache_path = path; }
+  bool load_gains();
+  bool save_gains() const;
 
   double dt;
   double period;
   double z;
 
-  struct COMTrajectory
-  {
-    keisan::Point2 position;
-    keisan::Point2 projected_position;
-  };
+  // The control of the state is the accumulated jerk input
+  State get_state() const override;
+  void set_state(const State & state) override;
+
+  Evaluation evaluate(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const override;
 
   COMTrajectory pop_front();
 
-  const std::deque<COMTrajectory> & get_com_trajectory() const { return com_trajectory; }
+  // Streaming evaluation, one sample per control tick
+  void begin(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    bool reset = false) override;
+  COMTrajectory advance(const std::deque<FootStepPlanner::FootStep> & foot_steps) override;
+  void update_steps(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed) override;
+
+  int get_remaining_samples() const override { return samples - sample; }
+  void skip_sample(const COMTrajectory & com) override;
+
+  const std::vector<int> & get_preview_ticks() const { return preview_ticks; }
+
+  // Room for the footsteps the longest preview sees, so begin() does not allocate after a switch
+  // to a longer period
+  void reserve_preview(size_t steps) { preview_ticks.reserve(steps); }
+  size_t get_window_size() const override { return preview_ticks.size(); }
+
+  bool is_settled(double tolerance = 1e-4) const override;
+
+  const RingBuffer<COMTrajectory> & get_com_trajectory() const { return com_trajectory; }
+
+protected:
+  // Hook for variants that keep the preview gains in their own storage
+  virtual void store_gains() {}
+
+  std::vector<double> f;  // Preview gain
+
+  std::vector<int> preview_ticks;
+  int start_tick;
+  int sample;
+
+  bool single_precision;
+  LIPMKernel<double> kernel;
 
 private:
+  void add_preview(
+    const std::deque<FootStepPlanner::FootStep> & foot_steps, const std::vector<int> & ticks,
+    int tick, double control[2]) const;
+
+  template <typename Scalar>
+  COMTrajectory step(
+    LIPMKernel<Scalar> & kernel, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    const std::vector<int> & ticks, int tick) const;
+  template <typename Scalar>
+  Evaluation evaluate(
+    LIPMKernel<Scalar> kernel, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+    const State & start) const;
+
+  // Footstep transitions inside the preview window, in ticks from the given one, the capacity of
+  // the given vector is reused
+  void fill_preview_ticks(
+    int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, int samples,
+    std::vector<int> & ticks) const;
+
+  void solve_dare_iterative(
+    const keisan::Matrix<4, 4> & Phai, const keisan::Matrix<4, 1> & G,
+    const keisan::Matrix<4, 4> & Qm, const keisan::Matrix<1, 1> & H,
+    const std::chrono::steady_clock::time_point & start_time);
+  void solve_dare_doubling(
+    const keisan::Matrix<4, 4> & Phai, const keisan::Matrix<4, 1> & G,
+    const keisan::Matrix<4, 4> & Qm, const keisan::Matrix<1, 1> & H,
+    const std::chrono::steady_clock::time_point & start_time);
+  bool is_over_budget(const std::chrono::steady_clock::time_point & start_time) const;
+
+  // DARE solver
+  int solver;
+  int max_iterations;
+  double max_duration;
+  DAREReport dare_report;
+  double preview_threshold;
+
   // Discrete-time system matrices
   keisan::Matrix<3, 3> A_d;
   keisan::Matrix<3, 1> B_d;
   keisan::Matrix<1, 3> C_d;
 
   // Gain matrix
+  keisan::Matrix<4, 4> P;  // DARE solution
   keisan::Matrix<1, 4> F;  // Feedback gain
-  std::vector<double> f;   // Preview gain
+
+  std::string gain_cache_path;
+
+  int samples;
 
   // Outputs
-  keisan::Matrix<3, 1> x_state;
-  keisan::Matrix<3, 1> y_state;
-  keisan::Point2 velocity;
-  std::deque<COMTrajectory> com_trajectory;
+  LIPMKernel<float> single_kernel;
+  RingBuffer<COMTrajectory> com_trajectory;
 };
 
 }  // namespace gankenkun
@@ -0,0 +1,180 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__LIPM__LIPM_KERNEL_HPP_
+#define GANKENKUN__LIPM__LIPM_KERNEL_HPP_
+
+#include <array>
+#include <cmath>
+
+#include "keisan/matrix.hpp"
+
+namespace gankenkun
+{
+
+// Per-sample LIPM state update in a chosen precision, sagittal and lateral axes side by side
+template <typename Scalar>
+class LIPMKernel
+{
+public:
+  LIPMKernel() { reset(); }
+
+  void set_model(
+    const keisan::Matrix<3, 3> & A_d, const keisan::Matrix<3, 1> & B_d,
+    const keisan::Matrix<1, 3> & C_d, const keisan::Matrix<1, 4> & F)
+  {
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        a[i][j] = static_cast<Scalar>(A_d[i][j]);
+      }
+
+      b[i] = static_cast<Scalar>(B_d[i][0]);
+      c[i] = static_cast<Scalar>(C_d[0][i]);
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+      k[i] = static_cast<Scalar>(F[0][i]);
+    }
+  }
+
+  void reset()
+  {
+    for (size_t i = 0; i < 3; ++i) {
+      state[i] = {0, 0};
+      next_state[i] = {0, 0};
+    }
+
+    reset_input();
+  }
+
+  void reset_input() { input = {0, 0}; }
+
+  // Rows hold position, velocity and acceleration, columns the sagittal and lateral axes
+  void set_state(const double values[3][2], const double control[2])
+  {
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 2; ++j) {
+        state[i][j] = static_cast<Scalar>(values[i][j]);
+      }
+    }
+
+    next_state = state;
+    input = {static_cast<Scalar>(control[0]), static_cast<Scalar>(control[1])};
+  }
+
+  void get_state(double values[3][2], double control[2]) const
+  {
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 2; ++j) {
+        values[i][j] = next_state[i][j];
+      }
+    }
+
+    control[0] = input[0];
+    control[1] = input[1];
+  }
+
+  // Restart the state difference used by the feedback term at the beginning of a step
+  void restart() { next_state = state; }
+
+  // Project the state onto the ZMP and compute the feedback part of the control input
+  void feedback(const double reference[2], double projected[2], double control[2])
+  {
+    for (size_t j = 0; j < 2; ++j) {
+      Scalar zmp = c[0] * next_state[0][j] + c[1] * next_state[1][j] + c[2] * next_state[2][j];
+
+      Scalar gain = k[0] * (static_cast<Scalar>(reference[j]) - zmp) +
+                    k[1] * (next_state[0][j] - state[0][j]) +
+                    k[2] * (next_state[1][j] - state[1][j]) +
+                    k[3] * (next_state[2][j] - state[2][j]);
+
+      projected[j] = zmp;
+      control[j] = gain;
+    }
+
+    state = next_state;
+  }
+
+  // Accumulate the control input and step the discrete-time system
+  void integrate(const double control[2])
+  {
+    for (size_t j = 0; j < 2; ++j) {
+      input[j] += static_cast<Scalar>(control[j]);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 2; ++j) {
+        next_state[i][j] = a[i][0] * state[0][j] + a[i][1] * state[1][j] + a[i][2] * state[2][j] +
+                           b[i] * input[j];
+      }
+    }
+  }
+
+  // Same update with the system matrices of a compile-time model, so its constant and zero
+  // entries fold into the code
+  template <typename Model>
+  void integrate(const double control[2])
+  {
+    for (size_t j = 0; j < 2; ++j) {
+      input[j] += static_cast<Scalar>(control[j]);
+    }
+
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 2; ++j) {
+        next_state[i][j] = static_cast<Scalar>(Model::a[i][0]) * state[0][j] +
+                           static_cast<Scalar>(Model::a[i][1]) * state[1][j] +
+                           static_cast<Scalar>(Model::a[i][2]) * state[2][j] +
+                           static_cast<Scalar>(Model::b[i]) * input[j];
+      }
+    }
+  }
+
+  double get_position(size_t axis) const { return next_state[0][axis]; }
+  double get_velocity(size_t axis) const { return next_state[1][axis]; }
+
+  bool is_settled(double tolerance) const
+  {
+    for (size_t i = 1; i < 3; ++i) {
+      for (size_t j = 0; j < 2; ++j) {
+        if (std::abs(static_cast<double>(state[i][j])) > tolerance) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+private:
+  // Discrete-time system and feedback gain
+  std::array<std::array<Scalar, 3>, 3> a;
+  std::array<Scalar, 3> b;
+  std::array<Scalar, 3> c;
+  std::array<Scalar, 4> k;
+
+  // Column 0 holds the sagittal axis and column 1 the lateral axis
+  std::array<std::array<Scalar, 2>, 3> state;
+  std::array<std::array<Scalar, 2>, 3> next_state;
+  std::array<Scalar, 2> input;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__LIPM__LIPM_KERNEL_HPP_
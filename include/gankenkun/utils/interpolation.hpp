@@ -0,0 +1,58 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__UTILS__INTERPOLATION_HPP_
+#define GANKENKUN__UTILS__INTERPOLATION_HPP_
+
+#include "keisan/geometry/point_2.hpp"
+
+namespace gankenkun
+{
+
+// Cubic Hermite between two samples a duration apart, fraction runs from 0 to 1
+inline double hermite(
+  double start, double start_rate, double end, double end_rate, double duration, double fraction)
+{
+  double fraction_2 = fraction * fraction;
+  double fraction_3 = fraction_2 * fraction;
+
+  return (2 * fraction_3 - 3 * fraction_2 + 1) * start +
+         (fraction_3 - 2 * fraction_2 + fraction) * duration * start_rate +
+         (-2 * fraction_3 + 3 * fraction_2) * end + (fraction_3 - fraction_2) * duration * end_rate;
+}
+
+inline keisan::Point2 hermite(
+  const keisan::Point2 & start, const keisan::Point2 & start_rate, const keisan::Point2 & end,
+  const keisan::Point2 & end_rate, double duration, double fraction)
+{
+  return keisan::Point2(
+    hermite(start.x, start_rate.x, end.x, end_rate.x, duration, fraction),
+    hermite(start.y, start_rate.y, end.y, end_rate.y, duration, fraction));
+}
+
+// Straight blend between two samples, fraction runs from 0 to 1
+inline double lerp(double start, double end, double fraction)
+{
+  return start * (1 - fraction) + end * fraction;
+}
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__UTILS__INTERPOLATION_HPP_
@@ -0,0 +1,55 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__UTILS__JSON_FILE_HPP_
+#define GANKENKUN__UTILS__JSON_FILE_HPP_
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+namespace gankenkun
+{
+
+// Write to a temporary file first so a crash never leaves a truncated file behind
+inline bool write_json_atomically(const std::string & path, const nlohmann::json & data)
+{
+  std::string temporary_path = path + ".tmp";
+  std::ofstream temporary_file(temporary_path);
+  if (!temporary_file.is_open()) {
+    return false;
+  }
+
+  temporary_file << data.dump(2);
+  temporary_file.close();
+
+  if (temporary_file.fail()) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+
+  return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__UTILS__JSON_FILE_HPP_
@@ -0,0 +1,102 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__UTILS__MEMO_CACHE_HPP_
+#define GANKENKUN__UTILS__MEMO_CACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace gankenkun
+{
+
+// Bounded map from quantized keys to results, the oldest entry is evicted first
+template <typename T>
+class MemoCache
+{
+public:
+  using Key = std::vector<int64_t>;
+
+  MemoCache() : capacity(0), hits(0), misses(0) {}
+
+  void set_capacity(size_t capacity)
+  {
+    this->capacity = capacity;
+    clear();
+  }
+
+  // Counts a hit or a miss, the pointer stays valid until the next insert
+  const T * find(const Key & key)
+  {
+    auto entry = entries.find(key);
+    if (entry == entries.end()) {
+      misses++;
+      return nullptr;
+    }
+
+    hits++;
+    return &entry->second;
+  }
+
+  void insert(const Key & key, T value)
+  {
+    if (capacity == 0) {
+      return;
+    }
+
+    auto inserted = entries.insert_or_assign(key, std::move(value));
+    if (!inserted.second) {
+      return;
+    }
+
+    order.push_back(key);
+    while (order.size() > capacity) {
+      entries.erase(order.front());
+      order.pop_front();
+    }
+  }
+
+  void clear()
+  {
+    entries.clear();
+    order.clear();
+    hits = 0;
+    misses = 0;
+  }
+
+  size_t size() const { return entries.size(); }
+  size_t get_hits() const { return hits; }
+  size_t get_misses() const { return misses; }
+
+private:
+  std::map<Key, T> entries;
+  std::deque<Key> order;
+  size_t capacity;
+  size_t hits;
+  size_t misses;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__UTILS__MEMO_CACHE_HPP_
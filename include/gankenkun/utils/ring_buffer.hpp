@@ -0,0 +1,124 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__UTILS__RING_BUFFER_HPP_
+#define GANKENKUN__UTILS__RING_BUFFER_HPP_
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace gankenkun
+{
+
+// Fixed-capacity FIFO that only allocates when its capacity is raised, reading or popping an
+// empty buffer throws instead of indexing into storage that may not exist
+template <typename T>
+class RingBuffer
+{
+public:
+  RingBuffer() : head(0), count(0) {}
+
+  void reserve(size_t capacity)
+  {
+    if (capacity <= items.size()) {
+      return;
+    }
+
+    std::vector<T> resized(capacity);
+    for (size_t i = 0; i < count; ++i) {
+      resized[i] = std::move((*this)[i]);
+    }
+
+    items = std::move(resized);
+    head = 0;
+  }
+
+  void push_back(const T & item)
+  {
+    if (count == items.size()) {
+      reserve(items.empty() ? 1 : items.size() * 2);
+    }
+
+    items[(head + count) % items.size()] = item;
+    count++;
+  }
+
+  void pop_front()
+  {
+    check_index(0);
+
+    head = (head + 1) % items.size();
+    count--;
+  }
+
+  void pop_back()
+  {
+    check_index(0);
+
+    count--;
+  }
+
+  void clear()
+  {
+    head = 0;
+    count = 0;
+  }
+
+  T & front() { return (*this)[0]; }
+  const T & front() const { return (*this)[0]; }
+
+  T & back() { return (*this)[count - 1]; }
+  const T & back() const { return (*this)[count - 1]; }
+
+  T & operator[](size_t index)
+  {
+    check_index(index);
+    return items[(head + index) % items.size()];
+  }
+
+  const T & operator[](size_t index) const
+  {
+    check_index(index);
+    return items[(head + index) % items.size()];
+  }
+
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+  size_t capacity() const { return items.size(); }
+
+private:
+  // Also covers a buffer that was never reserved, its count is always zero
+  void check_index(size_t index) const
+  {
+    if (index >= count) {
+      throw std::out_of_range("Ring buffer index out of range!");
+    }
+  }
+
+  std::vector<T> items;
+  size_t head;
+  size_t count;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__UTILS__RING_BUFFER_HPP_
@@ -50,9 +50,22 @@ public:
   void set_config(const nlohmann::json & kinematic_data);
   void solve_inverse_kinematics(const Foot & left_foot, const Foot & right_foot);
 
+  // Solve the legs in float instead of double
+  void set_single_precision(bool single_precision);
+
   const std::array<keisan::Angle<double>, 23> & get_angles() const { return angles; }
 
 private:
+  struct LegAngles
+  {
+    double hip_roll;
+    double hip_pitch;
+    double knee_pitch;
+  };
+
+  template <typename Scalar>
+  LegAngles solve_leg(double x, double y, double z, double yaw) const;
+
   double ankle_length;
   double calf_length;
   double knee_length;
@@ -61,6 +74,8 @@ private:
   double x_offset;
   double y_offset;
 
+  bool single_precision;
+
   std::array<keisan::Angle<double>, 23> angles;
 };
 
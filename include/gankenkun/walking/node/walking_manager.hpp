@@ -21,11 +21,25 @@
 #ifndef GANKENKUN__WALKING__NODE__WALKING_MANAGER_HPP_
 #define GANKENKUN__WALKING__NODE__WALKING_MANAGER_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
 
-#include "gankenkun/lipm/lipm.hpp"
+#include "gankenkun/com/batch_evaluator.hpp"
+#include "gankenkun/com/center_of_mass_generator.hpp"
+#include "gankenkun/com/mpc.hpp"
+#include "gankenkun/com/piecewise_trajectory.hpp"
+#include "gankenkun/lipm/fixed_lipm.hpp"
+#include "gankenkun/utils/interpolation.hpp"
+#include "gankenkun/utils/memo_cache.hpp"
 #include "gankenkun/walking/kinematics/kinematics.hpp"
 #include "gankenkun/walking/planner/foot_step_planner.hpp"
+#include "gankenkun/walking/planner/foot_step_search.hpp"
 #include "tachimawari/joint/joint.hpp"
 
 namespace gankenkun
@@ -36,36 +50,187 @@ class WalkingManager
 public:
   using FootStep = FootStepPlanner::FootStep;
 
+  enum { PREVIEW_GENERATOR = 0, DCM_GENERATOR = 1, MPC_GENERATOR = 2 };
+
+  // Steps replayed from the memo and steps computed since the last config
+  struct MemoReport
+  {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+  };
+
   WalkingManager();
 
   void load_config(const std::string & path);
   void set_config(const nlohmann::json & walking_data, const nlohmann::json & kinematic_data);
 
+  // From a stop() call to the first sample of the stopping plan
+  struct StopReport
+  {
+    double latency = 0.0;  // Of the last stop, in seconds
+    double max_latency = 0.0;
+    size_t count = 0;
+  };
+
+  // Lock free, process() applies it on its next call, a replayed step continues live instead
   void stop();
+  StopReport get_stop_report();
+
   void update_time();
+  void update_pose();
   void update_joints();
   void process();
   bool replan();
 
   const std::vector<tachimawari::joint::Joint> & get_joints() const { return joints; }
 
+  // Applied from the gain bank when the next step starts, false when the bank does not cover it,
+  // the planner window is sized for the longest period of the bank
+  bool set_com_target(double com_height, double com_period);
+
+  MemoReport get_memo_report();
+
+  // Closed-form COM of the recent steps, one segment per step, only filled when segments are
+  // enabled, which needs the DCM generator
+  const PiecewiseTrajectory & get_com_segments() const { return com_segments; }
+
+  // Copy of the current model and state that candidate footsteps can be scored against on the
+  // caller's thread, the walking loop keeps its own
+  std::unique_ptr<CenterOfMassGenerator> clone_com_generator();
+
+  // Solve time and active constraints of the last MPC tick, all zero with another generator
+  MPC::SolverReport get_mpc_report();
+
   void remove_steps();
+
+  // Safe to call from another thread, mid-step only the footsteps after the next one are replaced,
+  // with obstacles set the footsteps are searched around them within the search budget
   void set_goal(
     const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation);
 
+  // Walk on to this goal after the current one without bringing the feet together in between
+  void queue_goal(
+    const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation);
+
+  // Walk with a body velocity in m/s and rad/s instead of towards a goal, cheap to call often,
+  // a changed command reshapes the steps after the next one when the current step ends
+  void set_velocity(const keisan::Point2 & velocity, double angular_velocity);
+
+  // Follow a polyline with headings in one continuous plan
+  void set_path(const std::vector<FootStepPlanner::Pose> & path);
+
+  void set_obstacles(
+    const std::vector<FootStepSearch::Circle> & circles,
+    const std::vector<FootStepSearch::Polygon> & polygons);
+  FootStepSearch::Report get_search_report();
+
   void set_position(const keisan::Point2 & position);
   void set_orientation(const keisan::Angle<double> & orientation);
 
   const keisan::Point2 & get_position() const { return robot_position; }
   bool is_running();
+  bool is_idle() const { return idle; }
+
+  // Period of process(), the LIPM runs every time_step and the joints are interpolated in between,
+  // both are kept from the first config
+  double get_servo_period() const { return servo_period; }
 
 private:
+  // Walking pose at a LIPM sample
+  struct Pose
+  {
+    keisan::Point2 com_position;
+    keisan::Point2 com_velocity;
+    keisan::Matrix<1, 3> left_offset = keisan::Matrix<1, 3>::zero();
+    keisan::Matrix<1, 3> right_offset = keisan::Matrix<1, 3>::zero();
+    double left_up = 0.0;
+    double right_up = 0.0;
+    double height_offset = 0.0;
+    keisan::Angle<double> orientation = keisan::make_radian(0.0);
+  };
+
+  // Outputs of a whole step relative to its support foot
+  struct MemoEntry
+  {
+    std::vector<Pose> poses;
+    std::vector<double> joints;  // Joint positions of every servo tick, back to back
+    std::vector<CenterOfMassGenerator::Segment> segments;  // Timed from the start of the step
+    std::vector<CenterOfMassGenerator::State> states;  // Generator state after every sample
+    CenterOfMassGenerator::State end_state;
+  };
+
+  enum { MEMO_NONE = 0, MEMO_RECORD = 1, MEMO_REPLAY = 2 };
+
+  enum {
+    NO_COMMAND = 0,
+    GOAL_COMMAND = 1,
+    VELOCITY_COMMAND = 2,
+    POSES_COMMAND = 3,
+    PATH_COMMAND = 4
+  };
+
+  bool is_standing() const;
+  void update_com_target();
+
+  void search_goal(
+    const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation);
+  const std::vector<FootStepPlanner::Pose> & select_solution(
+    const FootStepPlanner & planner, const CenterOfMassGenerator & generator,
+    const FootStepPlanner::Pose & start, int support, int plan_status);
+  void request_command(int command);
+  bool can_replan_tail() const;
+  void plan_command(int command);
+  void replan_command(int command);
+  void flush_goals();
+  void apply_stop();
+  void measure_stop();
+  void get_plan_start(keisan::Point2 & position, keisan::Angle<double> & orientation) const;
+
+  void start_memo();
+  void finish_memo();
+  void leave_replay();
+  void replay_pose();
+  MemoCache<MemoEntry>::Key get_memo_key() const;
+  Pose shift_pose(const Pose & pose, const keisan::Point2 & origin, double rotation) const;
+
   Kinematics kinematics;
-  LIPM lipm;
   FootStepPlanner foot_step_planner;
 
+  // Guards the plan between goal updates and process()
+  std::mutex mutex;
+
+  // Command that has to wait for the current step to end
+  int pending_command;
+  keisan::Point2 pending_position;
+  keisan::Angle<double> pending_orientation;
+  std::vector<FootStepPlanner::Pose> pending_poses;  // Searched poses or a path
+
+  // Goals to chain onto the plan once its footsteps may change
+  std::deque<FootStepPlanner::Pose> queued_goals;
+
+  std::atomic<bool> stop_requested;
+  std::atomic<std::chrono::steady_clock::rep> stop_request_time;
+
+  // Set from the applied stop until the first sample of its plan
+  bool stop_measuring;
+  std::chrono::steady_clock::rep stop_start_time;
+  StopReport stop_report;
+
+  // Obstacle-aware search, run by the caller of set_goal() outside the walking loop lock
+  std::mutex search_mutex;
+  FootStepSearch foot_step_search;
+  double search_max_duration;
+  std::vector<FootStepPlanner::Pose> search_poses;
+
+  // Search plans are scored on the COM model when a ZMP error bound is set
+  double search_max_zmp_error;
+  std::unique_ptr<BatchEvaluator> search_evaluator;
+
   int status;
   bool initialized;
+  bool configured;
+  bool idle;
   int next_support;
   keisan::Point2 robot_position;
   keisan::Angle<double> robot_orientation;
@@ -76,6 +241,9 @@ private:
   double plan_period;
   double step_frames;
   double com_period;
+  double servo_period;
+  int interpolation_steps;
+  int interpolation_step;
 
   // Posture parameters
   double com_height;
@@ -91,11 +259,62 @@ private:
   keisan::Point2 max_stride;
   keisan::Angle<double> max_rotation;
 
+  // COM generator, lipm or mpc points at it when that generator is selected
+  int com_generator_type;
+  std::unique_ptr<CenterOfMassGenerator> com_generator;
+  LIPM * lipm;
+  MPC * mpc;
+
+  // LIPM parameters
+  std::string gain_cache_path;
+  int dare_solver;
+  int dare_max_iterations;
+  double dare_max_duration;
+  double preview_threshold;
+  bool lipm_single_precision;
+
+  // COM segments, the joints sample them instead of interpolating between LIPM samples
+  bool segments_enabled;
+  PiecewiseTrajectory com_segments;
+  int pose_tick;
+
+  // MPC parameters
+  double mpc_horizon;
+  int mpc_max_iterations;
+  double mpc_max_duration;
+  double mpc_zmp_margin;
+
+  // Gain bank parameters
+  GainBank gain_bank;
+  std::string gain_bank_path;
+  double target_com_height;
+  double target_com_period;
+  double height_offset;
+  double height_offset_delta;
+  double height_offset_target;
+
+  // Periodic gait memo, the step parameters and the entry state are quantized separately
+  bool memo_enabled;
+  double memo_resolution;
+  double memo_state_resolution;
+  MemoCache<MemoEntry> memo;
+  int memo_mode;
+  MemoCache<MemoEntry>::Key memo_key;
+  MemoEntry memo_entry;
+  const MemoEntry * memo_replay;
+  size_t memo_sample;
+  size_t memo_tick;
+  keisan::Point2 memo_origin;
+  double memo_rotation;
+
   double left_up;
   double right_up;
 
   std::vector<tachimawari::joint::Joint> joints;
 
+  Pose previous_pose;
+  Pose current_pose;
+
   keisan::Matrix<1, 3> left_offset = keisan::Matrix<1, 3>::zero();
   keisan::Matrix<1, 3> left_offset_delta = keisan::Matrix<1, 3>::zero();
   keisan::Matrix<1, 3> left_foot_target = keisan::Matrix<1, 3>::zero();
@@ -26,11 +26,15 @@
 #include <string>
 
 #include "gankenkun/walking/node/walking_manager.hpp"
+#include "geometry_msgs/msg/twist.hpp"
+#include "nav_msgs/msg/path.hpp"
+#include "std_msgs/msg/empty.hpp"
 #include "gankenkun_interfaces/msg/point2.hpp"
 #include "gankenkun_interfaces/msg/set_walking.hpp"
 #include "gankenkun_interfaces/msg/status.hpp"
 #include "kansei_interfaces/msg/status.hpp"
 #include "tachimawari_interfaces/msg/set_joints.hpp"
+#include "visualization_msgs/msg/marker_array.hpp"
 
 namespace gankenkun
 {
@@ -43,6 +47,10 @@ public:
   using Point2 = gankenkun_interfaces::msg::Point2;
   using KanseiStatus = kansei_interfaces::msg::Status;
   using SetWalking = gankenkun_interfaces::msg::SetWalking;
+  using Twist = geometry_msgs::msg::Twist;
+  using Path = nav_msgs::msg::Path;
+  using Empty = std_msgs::msg::Empty;
+  using MarkerArray = visualization_msgs::msg::MarkerArray;
 
   WalkingNode(
     const rclcpp::Node::SharedPtr & node, const std::shared_ptr<WalkingManager> & walking_manager);
@@ -52,12 +60,25 @@ public:
 private:
   void publish_joints();
   void publish_status();
+  void log_mpc_report();
+  void log_memo_report();
+  void log_stop_report();
 
   std::shared_ptr<WalkingManager> walking_manager;
 
   rclcpp::Node::SharedPtr node;
 
+  // Memo steps and stops counted at the last reports
+  size_t memo_steps;
+  size_t stop_count;
+
   rclcpp::Subscription<SetWalking>::SharedPtr set_walking_subscriber;
+  rclcpp::Subscription<SetWalking>::SharedPtr queue_goal_subscriber;
+  rclcpp::Subscription<Twist>::SharedPtr set_velocity_subscriber;
+  rclcpp::Subscription<Path>::SharedPtr set_path_subscriber;
+  rclcpp::Subscription<MarkerArray>::SharedPtr set_obstacles_subscriber;
+  rclcpp::Subscription<Point2>::SharedPtr set_com_target_subscriber;
+  rclcpp::Subscription<Empty>::SharedPtr stop_subscriber;
   rclcpp::Subscription<Point2>::SharedPtr set_odometry_subscriber;
   rclcpp::Subscription<KanseiStatus>::SharedPtr orientation_subscriber;
 
@@ -65,6 +86,7 @@ private:
   rclcpp::Publisher<WalkingStatus>::SharedPtr status_publisher;
 
   rclcpp::CallbackGroup::SharedPtr set_walking_group;
+  rclcpp::CallbackGroup::SharedPtr stop_group;
 };
 
 }  // namespace gankenkun
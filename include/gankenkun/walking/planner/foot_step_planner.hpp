@@ -22,6 +22,7 @@
 #define GANKENKUN__WALKING__PLANNER__FOOT_STEP_PLANNER_HPP_
 
 #include <deque>
+#include <vector>
 
 #include "keisan/angle.hpp"
 #include "keisan/geometry/point_2.hpp"
@@ -39,31 +40,125 @@ public:
   struct FootStep
   {
     double time;
+    int tick;  // Time in control ticks, all scheduling compares these
     keisan::Point2 position;
     keisan::Angle<double> rotation;
     int support_foot;
   };
 
+  // Body pose the plan walks through
+  struct Pose
+  {
+    keisan::Point2 position;
+    keisan::Angle<double> orientation;
+  };
+
   FootStepPlanner();
 
   void set_parameters(
     const keisan::Point2 & max_stride, const keisan::Angle<double> & max_rotation, double period,
-    double width);
+    double width, double time_step);
+
+  // Only this many steps are kept materialized, zero plans all the way to the goal
+  void set_window(size_t window);
 
   void plan(
     const keisan::Point2 & target_position, const keisan::Angle<double> & target_orientation,
     keisan::Point2 & current_position, keisan::Angle<double> & current_orientation,
     int next_support, int status);
 
+  // Keep the first steps, they are already committed, and plan the rest towards a new target
+  void replan_tail(
+    const keisan::Point2 & target_position, const keisan::Angle<double> & target_orientation,
+    size_t keep);
+
+  // Step through the body poses in order and stop at the last one
+  void plan_poses(
+    const std::vector<Pose> & poses, const keisan::Point2 & current_position,
+    const keisan::Angle<double> & current_orientation, int next_support, int status);
+  void replan_poses(const std::vector<Pose> & poses, size_t keep);
+
+  // Follow a polyline with headings in steps as long as the limits allow, without stopping at
+  // its vertices, and stop at its end
+  void plan_path(
+    const std::vector<Pose> & path, const keisan::Point2 & current_position,
+    const keisan::Angle<double> & current_orientation, int next_support, int status);
+  void replan_path(const std::vector<Pose> & path, size_t keep);
+
+  // Walk on to the goal after the current target, and after the goals queued before it, the
+  // first kept steps stay and the index of the first replaced step is returned
+  size_t queue_goal(const Pose & goal, size_t keep);
+
+  // Walk with the commanded body velocity, one step is appended for every step that is consumed
+  void plan_velocity(
+    const keisan::Point2 & current_position, const keisan::Angle<double> & current_orientation,
+    int next_support, int status);
+  void replan_velocity(size_t keep);
+  bool is_velocity_mode() const { return phase == VELOCITY_PHASE; }
+
+  // Linear velocity in the body frame in m/s and angular velocity in rad/s
+  void set_velocity(const keisan::Point2 & velocity, double angular_velocity);
+
+  // The command differs from the one the velocity window was built with, until the next replan
+  bool is_velocity_changed() const { return velocity_changed; }
+
+  // The stop after the step being stepped to is worked out once per support phase, so applying
+  // it is only a copy, false when the feet already come together
+  void prepare_stop();
+  bool apply_stop();
+
+  // Continue the last plan until the window is full again
+  void extend();
+  bool is_complete() const { return phase == COMPLETE_PHASE; }
+
   void print_foot_steps();
 
   std::deque<FootStep> foot_steps;
 
 private:
+  enum { WALKING_PHASE = 0, COMPLETE_PHASE = 1, VELOCITY_PHASE = 2, PATH_PHASE = 3 };
+
+  static constexpr size_t MIN_VELOCITY_WINDOW = 4;
+
+  void start(
+    const keisan::Point2 & current_position, const keisan::Angle<double> & current_orientation,
+    int next_support, int status);
+  void resume(size_t keep);
+  void set_waypoints(const std::vector<Pose> & poses);
+  std::vector<Pose> resample_path(const std::vector<Pose> & path) const;
+  bool add_step();
+  void set_stride();
+  void advance(double count);
+  void add_support_step(const keisan::Point2 & position, const keisan::Angle<double> & orientation);
+
   keisan::Point2 max_stride;
   keisan::Angle<double> max_rotation;
   double period;
   double width;
+  double time_step;
+  size_t window;
+
+  // Where the last plan stopped materializing steps
+  keisan::Point2 target_position;
+  keisan::Angle<double> target_orientation;
+  keisan::Point2 current_position;
+  keisan::Angle<double> current_orientation;
+  keisan::Point2 stride;
+  double stride_angle;
+  keisan::Point2 velocity;
+  double angular_velocity;
+  bool velocity_changed;
+  std::deque<Pose> goals;
+  std::vector<FootStep> stop_steps;  // Replace everything after the step being stepped to
+  std::vector<Pose> waypoints;
+  size_t waypoint;
+  int waypoint_steps;  // Strides left to the current waypoint
+  int next_support;
+  int plan_status;
+  int phase;
+  double periods;
+  double time;
+  int tick;
 };
 
 }  // namespace gankenkun
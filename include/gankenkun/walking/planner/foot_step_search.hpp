@@ -0,0 +1,163 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef GANKENKUN__WALKING__PLANNER__FOOT_STEP_SEARCH_HPP_
+#define GANKENKUN__WALKING__PLANNER__FOOT_STEP_SEARCH_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "gankenkun/walking/planner/foot_step_planner.hpp"
+#include "keisan/angle.hpp"
+#include "keisan/geometry/point_2.hpp"
+
+namespace gankenkun
+{
+
+// Anytime footstep search around obstacles, ARA* on the lattice of body poses spanned by the
+// stride limits that keeps tightening its heuristic weight until the time budget runs out
+class FootStepSearch
+{
+public:
+  using Pose = FootStepPlanner::Pose;
+
+  struct Circle
+  {
+    keisan::Point2 center;
+    double radius;
+  };
+
+  struct Polygon
+  {
+    std::vector<keisan::Point2> vertices;
+  };
+
+  struct Report
+  {
+    int iterations = 0;
+    int expansions = 0;
+    double weight = 0.0;  // Bound on the step count of the plan relative to the optimal one
+    double duration = 0.0;
+    bool found = false;  // False when the plan only gets as close to the goal as the search did
+  };
+
+  FootStepSearch();
+
+  // Steps are counted in the same world frame strides as the planner uses
+  void set_parameters(
+    const keisan::Point2 & max_stride, const keisan::Angle<double> & max_rotation,
+    double clearance);
+
+  // The weight goes from the initial one down to one by the given step
+  void set_weights(double initial_weight, double weight_step);
+  void set_max_nodes(size_t max_nodes) { this->max_nodes = max_nodes; }
+
+  void set_obstacles(const std::vector<Circle> & circles, const std::vector<Polygon> & polygons);
+  bool has_obstacles() const { return !circles.empty() || !polygons.empty(); }
+
+  // The body keeps the clearance from every obstacle
+  bool is_free(const keisan::Point2 & position) const;
+
+  // Body poses from the first step to the goal, a non-positive duration disables the deadline
+  bool plan(const Pose & start, const Pose & goal, double max_duration, std::vector<Pose> & poses);
+
+  const Report & get_report() const { return report; }
+
+  // Plans of the passes of the last search that each cost less than the one before, the last one
+  // is the returned plan, empty when no plan reached the goal
+  const std::vector<std::vector<Pose>> & get_solutions() const { return solutions; }
+
+private:
+  // Extra cost of a step that turns, so the plan does not turn for nothing
+  static constexpr double TURN_COST = 0.1;
+
+  struct Action
+  {
+    int x;
+    int y;
+    int angle;
+  };
+
+  struct Node
+  {
+    int x;
+    int y;
+    int angle;
+    double g;
+    double h;
+    int parent;
+    bool open;
+    bool closed;
+    bool inconsistent;
+  };
+
+  struct Entry
+  {
+    double key;
+    double g;
+    int node;
+
+    bool operator>(const Entry & other) const { return key > other.key; }
+  };
+
+  Pose get_pose(const Node & node) const;
+  int get_node(int x, int y, int angle);
+  double get_heuristic(const Pose & pose) const;
+  bool is_free(const Pose & from, const Pose & to) const;
+  bool is_within_step(const Pose & from, const Pose & to) const;
+  void push(int node, double weight);
+  bool improve_path(double weight, const std::chrono::steady_clock::time_point & deadline);
+  void trace(int node, std::vector<Pose> & poses) const;
+  void trace_goal(std::vector<Pose> & poses) const;
+
+  keisan::Point2 max_stride;
+  keisan::Angle<double> max_rotation;
+  double clearance;
+  double initial_weight;
+  double weight_step;
+  size_t max_nodes;
+
+  std::vector<Circle> circles;
+  std::vector<Polygon> polygons;
+
+  // Lattice spacing, half strides forward and backward, whole strides sideways and in rotation
+  std::vector<Action> actions;
+  keisan::Point2 spacing;
+  int headings;  // Number of distinct headings, zero when they do not wrap around
+
+  // Search state, kept between plans so its storage is reused
+  Pose start;
+  Pose goal;
+  std::vector<Node> nodes;
+  std::unordered_map<int64_t, int> lattice;
+  std::vector<Entry> heap;
+  int goal_node;
+  double goal_cost;
+  int closest_node;
+
+  Report report;
+  std::vector<std::vector<Pose>> solutions;
+};
+
+}  // namespace gankenkun
+
+#endif  // GANKENKUN__WALKING__PLANNER__FOOT_STEP_SEARCH_HPP_
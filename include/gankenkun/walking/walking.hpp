@@ -25,5 +25,6 @@
 #include "gankenkun/walking/node/walking_manager.hpp"
 #include "gankenkun/walking/node/walking_node.hpp"
 #include "gankenkun/walking/planner/foot_step_planner.hpp"
+#include "gankenkun/walking/planner/foot_step_search.hpp"
 
 #endif  // GANKENKUN__WALKING__WALKING_HPP_
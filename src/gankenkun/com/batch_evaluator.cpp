@@ -0,0 +1,146 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/batch_evaluator.hpp"
+
+#include <algorithm>
+
+namespace gankenkun
+{
+
+BatchEvaluator::BatchEvaluator(size_t threads)
+: generation(0),
+  active_workers(0),
+  stopping(false),
+  generator(nullptr),
+  candidates(nullptr),
+  start(nullptr),
+  results(nullptr),
+  job_size(0),
+  next_index(0),
+  finished(0)
+{
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back([this]() { work(); });
+  }
+}
+
+BatchEvaluator::~BatchEvaluator()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  wake_condition.notify_all();
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+}
+
+std::vector<BatchEvaluator::Evaluation> BatchEvaluator::evaluate(
+  const CenterOfMassGenerator & generator, const std::vector<FootSteps> & candidates,
+  const State & start)
+{
+  std::lock_guard<std::mutex> batch_lock(batch_mutex);
+
+  std::vector<Evaluation> results(candidates.size());
+  if (candidates.empty()) {
+    return results;
+  }
+
+  {
+    // Workers still draining the previous job must leave before it is replaced
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [this]() { return active_workers == 0; });
+
+    this->generator = &generator;
+    this->candidates = &candidates;
+    this->start = &start;
+    this->results = &results;
+    job_size = candidates.size();
+    next_index = 0;
+    finished = 0;
+
+    generation++;
+  }
+
+  wake_condition.notify_all();
+
+  run_job();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_condition.wait(lock, [this]() { return finished == job_size; });
+
+  return results;
+}
+
+void BatchEvaluator::work()
+{
+  size_t seen_generation = 0;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake_condition.wait(lock, [&]() { return stopping || generation != seen_generation; });
+
+      if (stopping) {
+        return;
+      }
+
+      seen_generation = generation;
+      active_workers++;
+    }
+
+    run_job();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      active_workers--;
+    }
+
+    done_condition.notify_all();
+  }
+}
+
+// Candidates are handed out one at a time so uneven sequence lengths balance across threads
+void BatchEvaluator::run_job()
+{
+  while (true) {
+    size_t index = next_index.fetch_add(1);
+    if (index >= job_size) {
+      return;
+    }
+
+    (*results)[index] = generator->evaluate((*candidates)[index], *start);
+
+    if (finished.fetch_add(1) + 1 == job_size) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done_condition.notify_all();
+    }
+  }
+}
+
+}  // namespace gankenkun
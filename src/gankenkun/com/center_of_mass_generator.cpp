@@ -0,0 +1,129 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/center_of_mass_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gankenkun
+{
+
+keisan::Point2 CenterOfMassGenerator::Segment::get_position(double time) const
+{
+  double t = time - start_time;
+  double growth_rate = omega > 0.0 ? std::exp(omega * t) : 0.0;
+  double decay_rate = omega > 0.0 ? std::exp(-omega * t) : 0.0;
+
+  auto position = keisan::Point2(0.0, 0.0);
+  for (int i = 3; i >= 0; --i) {
+    position.x = position.x * t + coefficients[i].x;
+    position.y = position.y * t + coefficients[i].y;
+  }
+
+  position.x += growth.x * growth_rate + decay.x * decay_rate;
+  position.y += growth.y * growth_rate + decay.y * decay_rate;
+
+  return position;
+}
+
+keisan::Point2 CenterOfMassGenerator::Segment::get_velocity(double time) const
+{
+  double t = time - start_time;
+  double growth_rate = omega > 0.0 ? omega * std::exp(omega * t) : 0.0;
+  double decay_rate = omega > 0.0 ? -omega * std::exp(-omega * t) : 0.0;
+
+  auto velocity = keisan::Point2(0.0, 0.0);
+  for (int i = 3; i >= 1; --i) {
+    velocity.x = velocity.x * t + i * coefficients[i].x;
+    velocity.y = velocity.y * t + i * coefficients[i].y;
+  }
+
+  velocity.x += growth.x * growth_rate + decay.x * decay_rate;
+  velocity.y += growth.y * growth_rate + decay.y * decay_rate;
+
+  return velocity;
+}
+
+CenterOfMassGenerator::State CenterOfMassGenerator::to_local(
+  const State & state, const keisan::Point2 & origin) const
+{
+  auto local = state;
+  local.position.x -= origin.x;
+  local.position.y -= origin.y;
+
+  return local;
+}
+
+CenterOfMassGenerator::State CenterOfMassGenerator::to_world(
+  const State & state, const keisan::Point2 & origin) const
+{
+  auto world = state;
+  world.position.x += origin.x;
+  world.position.y += origin.y;
+
+  return world;
+}
+
+CenterOfMassGenerator::Evaluation CenterOfMassGenerator::simulate(
+  CenterOfMassGenerator & generator, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+  const State & start)
+{
+  auto evaluation = Evaluation();
+
+  generator.set_state(start);
+
+  double sum_zmp_error = 0.0;
+
+  // The last step of a plan only pads the preview, the walking loop never steps onto it
+  std::deque<FootStepPlanner::FootStep> window(foot_steps);
+  while (window.size() > 2) {
+    generator.begin(window[0].tick, window);
+
+    while (generator.get_remaining_samples() > 0) {
+      auto com = generator.advance(window);
+
+      double zmp_error = std::hypot(
+        com.projected_position.x - window.front().position.x,
+        com.projected_position.y - window.front().position.y);
+
+      evaluation.max_zmp_error = std::max(evaluation.max_zmp_error, zmp_error);
+      sum_zmp_error += zmp_error * zmp_error;
+
+      evaluation.com_trajectory.push_back(com);
+    }
+
+    window.pop_front();
+  }
+
+  if (!evaluation.com_trajectory.empty()) {
+    evaluation.rms_zmp_error = std::sqrt(sum_zmp_error / evaluation.com_trajectory.size());
+
+    const auto & com = evaluation.com_trajectory.back();
+    evaluation.final_com_error = std::hypot(
+      com.position.x - window.front().position.x, com.position.y - window.front().position.y);
+  }
+
+  evaluation.final_state = generator.get_state();
+
+  return evaluation;
+}
+
+}  // namespace gankenkun
@@ -0,0 +1,201 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/dcm.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gankenkun
+{
+
+DCM::DCM()
+: z(0.0),
+  dt(0.0),
+  omega(0.0),
+  zmp(keisan::Point2(0.0, 0.0)),
+  decay(keisan::Point2(0.0, 0.0)),
+  growth(keisan::Point2(0.0, 0.0)),
+  position(keisan::Point2(0.0, 0.0)),
+  velocity(keisan::Point2(0.0, 0.0)),
+  start_tick(0),
+  sample(0),
+  samples(0),
+  window_size(0)
+{
+}
+
+std::unique_ptr<CenterOfMassGenerator> DCM::clone() const
+{
+  return std::make_unique<DCM>(*this);
+}
+
+void DCM::set_parameters(double z, double dt)
+{
+  this->z = z;
+  this->dt = dt;
+
+  omega = std::sqrt(9.8 / z);
+
+  position = keisan::Point2(0.0, 0.0);
+  velocity = keisan::Point2(0.0, 0.0);
+  zmp = keisan::Point2(0.0, 0.0);
+
+  sample = 0;
+  samples = 0;
+}
+
+// Plan the DCM backwards from the last footstep, then pick the ZMP that brings it there
+void DCM::begin(int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool)
+{
+  start_tick = tick;
+  sample = 0;
+  samples = foot_steps[1].tick - tick;
+  window_size = foot_steps.size() - 1;
+
+  // The DCM comes to rest over the last footstep
+  keisan::Point2 end_dcm = foot_steps.back().position;
+  for (int index = static_cast<int>(foot_steps.size()) - 2; index >= 1; --index) {
+    const auto & support = foot_steps[index].position;
+    double duration = (foot_steps[index + 1].tick - foot_steps[index].tick) * dt;
+    double attenuation = std::exp(-omega * duration);
+
+    end_dcm.x = support.x + attenuation * (end_dcm.x - support.x);
+    end_dcm.y = support.y + attenuation * (end_dcm.y - support.y);
+  }
+
+  // Equals the support foot when the COM is on the plan, corrects it otherwise
+  double attenuation = std::exp(-omega * std::max(samples, 1) * dt);
+  auto start_dcm = keisan::Point2(
+    position.x + velocity.x / omega, position.y + velocity.y / omega);
+
+  zmp.x = (end_dcm.x * attenuation - start_dcm.x) / (attenuation - 1.0);
+  zmp.y = (end_dcm.y * attenuation - start_dcm.y) / (attenuation - 1.0);
+
+  growth.x = (start_dcm.x - zmp.x) / 2;
+  growth.y = (start_dcm.y - zmp.y) / 2;
+
+  decay.x = position.x - zmp.x - growth.x;
+  decay.y = position.y - zmp.y - growth.y;
+}
+
+// The rest of the step is solved again from the current state towards the new footsteps
+void DCM::update_steps(const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t)
+{
+  if (sample < samples) {
+    begin(start_tick + sample, foot_steps);
+  }
+}
+
+void DCM::skip_sample(const COMTrajectory &) { sample++; }
+
+DCM::COMTrajectory DCM::advance(const std::deque<FootStepPlanner::FootStep> &)
+{
+  sample++;
+
+  double time = sample * dt;
+  double decay_rate = std::exp(-omega * time);
+  double growth_rate = std::exp(omega * time);
+
+  position.x = zmp.x + decay.x * decay_rate + growth.x * growth_rate;
+  position.y = zmp.y + decay.y * decay_rate + growth.y * growth_rate;
+
+  velocity.x = omega * (growth.x * growth_rate - decay.x * decay_rate);
+  velocity.y = omega * (growth.y * growth_rate - decay.y * decay_rate);
+
+  auto com = COMTrajectory();
+
+  com.position = position;
+  com.velocity = velocity;
+  com.projected_position = zmp;
+
+  return com;
+}
+
+bool DCM::is_settled(double tolerance) const
+{
+  auto state = get_state();
+
+  return std::abs(state.velocity.x) <= tolerance && std::abs(state.velocity.y) <= tolerance &&
+         std::abs(state.acceleration.x) <= tolerance &&
+         std::abs(state.acceleration.y) <= tolerance;
+}
+
+bool DCM::get_segment(Segment & segment) const
+{
+  segment = Segment();
+
+  segment.start_time = start_tick * dt;
+  segment.duration = samples * dt;
+  segment.omega = omega;
+  segment.coefficients[0] = zmp;
+  segment.growth = growth;
+  segment.decay = decay;
+
+  return true;
+}
+
+DCM::State DCM::get_state() const
+{
+  auto state = State();
+
+  state.position = position;
+  state.velocity = velocity;
+  state.acceleration.x = omega * omega * (position.x - zmp.x);
+  state.acceleration.y = omega * omega * (position.y - zmp.y);
+  state.control = zmp;
+
+  return state;
+}
+
+void DCM::set_state(const State & state)
+{
+  position = state.position;
+  velocity = state.velocity;
+  zmp = state.control;
+}
+
+DCM::State DCM::to_local(const State & state, const keisan::Point2 & origin) const
+{
+  auto local = CenterOfMassGenerator::to_local(state, origin);
+  local.control.x -= origin.x;
+  local.control.y -= origin.y;
+
+  return local;
+}
+
+DCM::State DCM::to_world(const State & state, const keisan::Point2 & origin) const
+{
+  auto world = CenterOfMassGenerator::to_world(state, origin);
+  world.control.x += origin.x;
+  world.control.y += origin.y;
+
+  return world;
+}
+
+DCM::Evaluation DCM::evaluate(
+  const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const
+{
+  DCM generator(*this);
+
+  return simulate(generator, foot_steps, start);
+}
+
+}  // namespace gankenkun
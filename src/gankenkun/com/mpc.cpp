@@ -0,0 +1,299 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/mpc.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+#include "gankenkun/lipm/lipm.hpp"
+
+namespace gankenkun
+{
+
+// Weights of the ZMP tracking error and of the jerk input
+static constexpr double ZMP_WEIGHT = 1.0;
+static constexpr double JERK_WEIGHT = 1e-6;
+
+// Tuned on the default timing, a larger step converges in fewer iterations at step changes
+static constexpr double ADMM_STEP_SIZE = 2.0;
+
+MPC::MPC()
+: z(0.0),
+  dt(0.0),
+  period(0.0),
+  horizon(0),
+  max_iterations(50),
+  max_duration(0.0),
+  zmp_margin(0.02),
+  start_tick(0),
+  sample(0),
+  samples(0),
+  window_size(0)
+{
+  std::fill(&state[0][0], &state[0][0] + 6, 0.0);
+  std::fill(control, control + 2, 0.0);
+}
+
+std::unique_ptr<CenterOfMassGenerator> MPC::clone() const
+{
+  return std::make_unique<MPC>(*this);
+}
+
+void MPC::set_parameters(double z, double dt, double period)
+{
+  this->z = z;
+  this->dt = dt;
+  this->period = period;
+
+  LIPM::discretize(z, dt, A_d, B_d, C_d);
+
+  horizon = std::max(static_cast<int>(round(period / dt)), 1);
+  size_t n = horizon;
+
+  // ZMP of stage k is C A^k x0 + sum of C A^(k - 1 - j) B u_j
+  zmp_state.assign(n * 3, 0.0);
+  std::vector<double> markov(n);
+
+  keisan::Matrix<1, 3> CA = C_d;
+  for (size_t k = 0; k < n; ++k) {
+    auto CB = CA * B_d;
+    markov[k] = CB[0][0];
+
+    CA = CA * A_d;
+    for (size_t i = 0; i < 3; ++i) {
+      zmp_state[k * 3 + i] = CA[0][i];
+    }
+  }
+
+  zmp_input.assign(n * n, 0.0);
+  for (size_t k = 0; k < n; ++k) {
+    for (size_t j = 0; j <= k; ++j) {
+      zmp_input[k * n + j] = markov[k - j];
+    }
+  }
+
+  // H = Q Pu' Pu + R I
+  std::vector<double> hessian(n * n, 0.0);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      double sum = 0.0;
+      for (size_t k = i; k < n; ++k) {
+        sum += zmp_input[k * n + i] * zmp_input[k * n + j];
+      }
+
+      hessian[i * n + j] = ZMP_WEIGHT * sum;
+      hessian[j * n + i] = ZMP_WEIGHT * sum;
+    }
+
+    hessian[i * n + i] += JERK_WEIGHT;
+  }
+
+  solver.set_step_size(ADMM_STEP_SIZE);
+  if (!solver.set_problem(hessian, zmp_input, n, n)) {
+    throw std::runtime_error("Failed to factorize the MPC problem!");
+  }
+
+  reference.assign(n, 0.0);
+  gradient.assign(n, 0.0);
+  lower.assign(n, 0.0);
+  upper.assign(n, 0.0);
+
+  solutions[0] = QPSolver::Solution();
+  solutions[1] = QPSolver::Solution();
+
+  std::fill(&state[0][0], &state[0][0] + 6, 0.0);
+  std::fill(control, control + 2, 0.0);
+
+  sample = 0;
+  samples = 0;
+}
+
+void MPC::set_solver(int max_iterations, double max_duration)
+{
+  this->max_iterations = max_iterations;
+  this->max_duration = max_duration;
+}
+
+void MPC::begin(int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset)
+{
+  if (reset) {
+    solutions[0] = QPSolver::Solution();
+    solutions[1] = QPSolver::Solution();
+  }
+
+  start_tick = tick;
+  sample = 0;
+  samples = foot_steps[1].tick - tick;
+
+  update_steps(foot_steps, 1);
+}
+
+// Every sample reads the footsteps again, only the window size follows the new ones
+void MPC::update_steps(const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t)
+{
+  window_size = 0;
+  for (size_t index = 1; index < foot_steps.size(); ++index) {
+    if (foot_steps[index].tick - start_tick >= samples + horizon) {
+      break;
+    }
+
+    window_size++;
+  }
+}
+
+MPC::COMTrajectory MPC::advance(const std::deque<FootStepPlanner::FootStep> & foot_steps)
+{
+  auto start_time = std::chrono::steady_clock::now();
+
+  solver_report = SolverReport();
+  solver_report.converged = true;
+
+  size_t n = horizon;
+
+  auto com = COMTrajectory();
+
+  // ZMP of the current state, the same sample the preview controller reports
+  com.projected_position.x =
+    C_d[0][0] * state[0][0] + C_d[0][1] * state[1][0] + C_d[0][2] * state[2][0];
+  com.projected_position.y =
+    C_d[0][0] * state[0][1] + C_d[0][1] * state[1][1] + C_d[0][2] * state[2][1];
+
+  for (int axis = 0; axis < 2; ++axis) {
+    // Support foot of every stage of the horizon
+    size_t index = 0;
+    for (size_t k = 0; k < n; ++k) {
+      int stage_tick = start_tick + sample + static_cast<int>(k) + 1;
+      while (index + 1 < foot_steps.size() && foot_steps[index + 1].tick <= stage_tick) {
+        index++;
+      }
+
+      const auto & position = foot_steps[index].position;
+      reference[k] = axis == 0 ? position.x : position.y;
+    }
+
+    // Tracking error of the free response, g = Q Pu' (Px x0 - r)
+    std::fill(gradient.begin(), gradient.end(), 0.0);
+    for (size_t k = 0; k < n; ++k) {
+      double free_zmp = zmp_state[k * 3] * state[0][axis] + zmp_state[k * 3 + 1] * state[1][axis] +
+                        zmp_state[k * 3 + 2] * state[2][axis];
+
+      double error = ZMP_WEIGHT * (free_zmp - reference[k]);
+      for (size_t j = 0; j <= k; ++j) {
+        gradient[j] += zmp_input[k * n + j] * error;
+      }
+
+      lower[k] = reference[k] - zmp_margin - free_zmp;
+      upper[k] = reference[k] + zmp_margin - free_zmp;
+    }
+
+    // The sagittal axis gets half of the budget, the lateral one the rest of it
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (max_duration > 0.0) {
+      deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(max_duration * (axis + 1) / 2));
+    }
+
+    auto report = solver.solve(gradient, lower, upper, solutions[axis], max_iterations, deadline);
+
+    solver_report.iterations += report.iterations;
+    solver_report.active_constraints += report.active_constraints;
+    solver_report.converged &= report.converged;
+
+    // Apply the first input of the horizon only
+    control[axis] = solutions[axis].x[0];
+
+    double next[3];
+    for (int i = 0; i < 3; ++i) {
+      next[i] = A_d[i][0] * state[0][axis] + A_d[i][1] * state[1][axis] +
+                A_d[i][2] * state[2][axis] + B_d[i][0] * control[axis];
+    }
+
+    for (int i = 0; i < 3; ++i) {
+      state[i][axis] = next[i];
+    }
+
+    QPSolver::shift(solutions[axis]);
+  }
+
+  sample++;
+
+  com.position = keisan::Point2(state[0][0], state[0][1]);
+  com.velocity = keisan::Point2(state[1][0], state[1][1]);
+
+  solver_report.duration =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  return com;
+}
+
+void MPC::skip_sample(const COMTrajectory &)
+{
+  sample++;
+
+  // Keep the warm start aligned with the horizon
+  QPSolver::shift(solutions[0]);
+  QPSolver::shift(solutions[1]);
+}
+
+bool MPC::is_settled(double tolerance) const
+{
+  return std::abs(state[1][0]) <= tolerance && std::abs(state[1][1]) <= tolerance &&
+         std::abs(state[2][0]) <= tolerance && std::abs(state[2][1]) <= tolerance;
+}
+
+MPC::State MPC::get_state() const
+{
+  auto state = State();
+
+  state.position = keisan::Point2(this->state[0][0], this->state[0][1]);
+  state.velocity = keisan::Point2(this->state[1][0], this->state[1][1]);
+  state.acceleration = keisan::Point2(this->state[2][0], this->state[2][1]);
+  state.control = keisan::Point2(control[0], control[1]);
+
+  return state;
+}
+
+void MPC::set_state(const State & state)
+{
+  this->state[0][0] = state.position.x;
+  this->state[0][1] = state.position.y;
+  this->state[1][0] = state.velocity.x;
+  this->state[1][1] = state.velocity.y;
+  this->state[2][0] = state.acceleration.x;
+  this->state[2][1] = state.acceleration.y;
+
+  control[0] = state.control.x;
+  control[1] = state.control.y;
+}
+
+MPC::Evaluation MPC::evaluate(
+  const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const
+{
+  // Only the iteration limit applies offline so results do not depend on the machine load
+  MPC generator(*this);
+  generator.set_solver(max_iterations, 0.0);
+
+  return simulate(generator, foot_steps, start);
+}
+
+}  // namespace gankenkun
@@ -0,0 +1,144 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/piecewise_trajectory.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gankenkun
+{
+
+// Timestamps within this much of a segment boundary count as on it
+static constexpr double TIME_EPSILON = 1e-9;
+
+PiecewiseTrajectory::PiecewiseTrajectory() : capacity(1024), tolerance(1e-6)
+{
+  segments.reserve(capacity);
+}
+
+void PiecewiseTrajectory::set_capacity(size_t capacity)
+{
+  this->capacity = std::max(capacity, static_cast<size_t>(1));
+  segments.reserve(this->capacity);
+
+  while (segments.size() > this->capacity) {
+    segments.pop_front();
+  }
+}
+
+void PiecewiseTrajectory::append(const Segment & segment)
+{
+  // A replanned step overrides what was appended for the same span
+  while (!segments.empty() && segments.back().start_time >= segment.start_time - TIME_EPSILON) {
+    segments.pop_back();
+  }
+
+  if (!segments.empty()) {
+    auto & last = segments.back();
+    if (last.get_end_time() > segment.start_time) {
+      last.duration = segment.start_time - last.start_time;
+    }
+
+    if (is_continued(segment)) {
+      last.duration = segment.get_end_time() - last.start_time;
+      return;
+    }
+  }
+
+  if (segments.size() == capacity) {
+    segments.pop_front();
+  }
+
+  segments.push_back(segment);
+}
+
+bool PiecewiseTrajectory::get_position(double time, keisan::Point2 & position) const
+{
+  const auto * segment = find(time);
+  if (!segment) {
+    return false;
+  }
+
+  position = segment->get_position(time);
+
+  return true;
+}
+
+bool PiecewiseTrajectory::get_velocity(double time, keisan::Point2 & velocity) const
+{
+  const auto * segment = find(time);
+  if (!segment) {
+    return false;
+  }
+
+  velocity = segment->get_velocity(time);
+
+  return true;
+}
+
+// Binary search for the last segment starting at or before the time
+const PiecewiseTrajectory::Segment * PiecewiseTrajectory::find(double time) const
+{
+  if (
+    segments.empty() || time < get_start_time() - TIME_EPSILON ||
+    time > get_end_time() + TIME_EPSILON) {
+    return nullptr;
+  }
+
+  size_t low = 0;
+  size_t high = segments.size();
+  while (high - low > 1) {
+    size_t middle = (low + high) / 2;
+    if (segments[middle].start_time <= time + TIME_EPSILON) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  return &segments[low];
+}
+
+bool PiecewiseTrajectory::is_continued(const Segment & segment) const
+{
+  const auto & last = segments.back();
+  if (tolerance <= 0.0 || last.omega != segment.omega) {
+    return false;
+  }
+
+  for (double time : {segment.start_time, segment.get_end_time()}) {
+    auto expected = last.get_position(time);
+    auto actual = segment.get_position(time);
+    if (std::hypot(expected.x - actual.x, expected.y - actual.y) > tolerance) {
+      return false;
+    }
+
+    expected = last.get_velocity(time);
+    actual = segment.get_velocity(time);
+    if (std::hypot(expected.x - actual.x, expected.y - actual.y) > tolerance) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace gankenkun
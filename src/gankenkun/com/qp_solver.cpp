@@ -0,0 +1,246 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/com/qp_solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gankenkun
+{
+
+QPSolver::QPSolver() : variables(0), rows(0), rho(0.1), sigma(1e-6), tolerance(1e-4) {}
+
+bool QPSolver::set_problem(
+  const std::vector<double> & hessian, const std::vector<double> & constraints, size_t variables,
+  size_t rows)
+{
+  this->variables = variables;
+  this->rows = rows;
+  this->constraints = constraints;
+
+  // Only the nonzero span of each row is visited, prediction matrices are triangular
+  row_begin.assign(rows, 0);
+  row_end.assign(rows, 0);
+  for (size_t i = 0; i < rows; ++i) {
+    const double * row = &constraints[i * variables];
+
+    size_t begin = 0;
+    while (begin < variables && row[begin] == 0.0) {
+      begin++;
+    }
+
+    size_t end = variables;
+    while (end > begin && row[end - 1] == 0.0) {
+      end--;
+    }
+
+    row_begin[i] = begin;
+    row_end[i] = end;
+  }
+
+  rhs.assign(variables, 0.0);
+  ax.assign(rows, 0.0);
+  dz.assign(rows, 0.0);
+  dual.assign(variables, 0.0);
+
+  // K = H + sigma I + rho A' A
+  factor = hessian;
+  for (size_t i = 0; i < variables; ++i) {
+    factor[i * variables + i] += sigma;
+
+    for (size_t j = 0; j <= i; ++j) {
+      double sum = 0.0;
+      for (size_t k = 0; k < rows; ++k) {
+        sum += constraints[k * variables + i] * constraints[k * variables + j];
+      }
+
+      factor[i * variables + j] += rho * sum;
+    }
+  }
+
+  // In-place Cholesky decomposition, only the lower triangle is used
+  for (size_t j = 0; j < variables; ++j) {
+    double diagonal = factor[j * variables + j];
+    for (size_t k = 0; k < j; ++k) {
+      diagonal -= factor[j * variables + k] * factor[j * variables + k];
+    }
+
+    if (diagonal <= 0.0) {
+      factor.clear();
+      return false;
+    }
+
+    diagonal = std::sqrt(diagonal);
+    factor[j * variables + j] = diagonal;
+
+    for (size_t i = j + 1; i < variables; ++i) {
+      double value = factor[i * variables + j];
+      for (size_t k = 0; k < j; ++k) {
+        value -= factor[i * variables + k] * factor[j * variables + k];
+      }
+
+      factor[i * variables + j] = value / diagonal;
+    }
+  }
+
+  return true;
+}
+
+QPSolver::Report QPSolver::solve(
+  const std::vector<double> & gradient, const std::vector<double> & lower,
+  const std::vector<double> & upper, Solution & solution, int max_iterations,
+  const std::chrono::steady_clock::time_point & deadline)
+{
+  auto start_time = std::chrono::steady_clock::now();
+
+  auto report = Report();
+
+  // Cold start when there is nothing to continue from
+  if (solution.x.size() != variables || solution.z.size() != rows || solution.y.size() != rows) {
+    solution.x.assign(variables, 0.0);
+    solution.z.assign(rows, 0.0);
+    solution.y.assign(rows, 0.0);
+  }
+
+  auto & x = solution.x;
+  auto & z = solution.z;
+  auto & y = solution.y;
+
+  // The bounds may have moved since the last solve
+  for (size_t i = 0; i < rows; ++i) {
+    z[i] = std::clamp(z[i], lower[i], upper[i]);
+  }
+
+  while (report.iterations < max_iterations && std::chrono::steady_clock::now() < deadline) {
+    report.iterations++;
+
+    // x = K^-1 (sigma x - g + A' (rho z - y))
+    for (size_t i = 0; i < rows; ++i) {
+      dz[i] = rho * z[i] - y[i];
+    }
+
+    multiply_transpose(dz, rhs);
+    for (size_t i = 0; i < variables; ++i) {
+      rhs[i] += sigma * x[i] - gradient[i];
+    }
+
+    // Swapping keeps both buffers at the problem size, neither is reallocated
+    substitute(rhs);
+    x.swap(rhs);
+
+    // Project onto the bounds and update the dual
+    multiply(x, ax);
+
+    report.primal_residual = 0.0;
+    for (size_t i = 0; i < rows; ++i) {
+      double projected = std::clamp(ax[i] + y[i] / rho, lower[i], upper[i]);
+
+      dz[i] = projected - z[i];
+      z[i] = projected;
+      y[i] += rho * (ax[i] - z[i]);
+
+      report.primal_residual = std::max(report.primal_residual, std::abs(ax[i] - z[i]));
+    }
+
+    multiply_transpose(dz, dual);
+
+    report.dual_residual = 0.0;
+    for (size_t i = 0; i < variables; ++i) {
+      report.dual_residual = std::max(report.dual_residual, rho * std::abs(dual[i]));
+    }
+
+    if (report.primal_residual < tolerance && report.dual_residual < tolerance) {
+      report.converged = true;
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < rows; ++i) {
+    if (z[i] <= lower[i] || z[i] >= upper[i]) {
+      report.active_constraints++;
+    }
+  }
+
+  report.duration =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  return report;
+}
+
+void QPSolver::shift(Solution & solution)
+{
+  for (auto * values : {&solution.x, &solution.z, &solution.y}) {
+    if (values->size() > 1) {
+      std::rotate(values->begin(), values->begin() + 1, values->end());
+      values->back() = (*values)[values->size() - 2];
+    }
+  }
+}
+
+void QPSolver::multiply(const std::vector<double> & x, std::vector<double> & result) const
+{
+  for (size_t i = 0; i < rows; ++i) {
+    const double * row = &constraints[i * variables];
+
+    double sum = 0.0;
+    for (size_t j = row_begin[i]; j < row_end[i]; ++j) {
+      sum += row[j] * x[j];
+    }
+
+    result[i] = sum;
+  }
+}
+
+void QPSolver::multiply_transpose(const std::vector<double> & z, std::vector<double> & result) const
+{
+  std::fill(result.begin(), result.end(), 0.0);
+
+  for (size_t i = 0; i < rows; ++i) {
+    const double * row = &constraints[i * variables];
+    for (size_t j = row_begin[i]; j < row_end[i]; ++j) {
+      result[j] += row[j] * z[i];
+    }
+  }
+}
+
+// Solve K x = b in place with the Cholesky factor, L y = b then L' x = y
+void QPSolver::substitute(std::vector<double> & x) const
+{
+  for (size_t i = 0; i < variables; ++i) {
+    double value = x[i];
+    for (size_t k = 0; k < i; ++k) {
+      value -= factor[i * variables + k] * x[k];
+    }
+
+    x[i] = value / factor[i * variables + i];
+  }
+
+  for (size_t i = variables; i-- > 0;) {
+    double value = x[i];
+    for (size_t k = i + 1; k < variables; ++k) {
+      value -= factor[k * variables + i] * x[k];
+    }
+
+    x[i] = value / factor[i * variables + i];
+  }
+}
+
+}  // namespace gankenkun
@@ -0,0 +1,50 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/lipm/fixed_lipm.hpp"
+
+namespace gankenkun
+{
+
+// Compiled-in profiles, an 8 ms control tick with 0.8 s, 1.0 s and 1.2 s previews
+using ControlTimeStep = std::ratio<8, 1000>;
+
+template class FixedLIPM<ControlTimeStep, 100>;
+template class FixedLIPM<ControlTimeStep, 125>;
+template class FixedLIPM<ControlTimeStep, 150>;
+
+std::unique_ptr<LIPM> make_lipm(double dt, double period)
+{
+  if (FixedLIPM<ControlTimeStep, 100>::is_matching(dt, period)) {
+    return std::make_unique<FixedLIPM<ControlTimeStep, 100>>();
+  }
+
+  if (FixedLIPM<ControlTimeStep, 125>::is_matching(dt, period)) {
+    return std::make_unique<FixedLIPM<ControlTimeStep, 125>>();
+  }
+
+  if (FixedLIPM<ControlTimeStep, 150>::is_matching(dt, period)) {
+    return std::make_unique<FixedLIPM<ControlTimeStep, 150>>();
+  }
+
+  return std::make_unique<LIPM>();
+}
+
+}  // namespace gankenkun
@@ -0,0 +1,257 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/lipm/gain_bank.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include "gankenkun/lipm/lipm.hpp"
+#include "gankenkun/utils/json_file.hpp"
+
+namespace gankenkun
+{
+
+// Bump whenever the bank layout or the DARE weights change
+static constexpr int GAIN_BANK_VERSION = 1;
+
+GainBank::GainBank()
+: time_step(0.0),
+  preview_threshold(0.0),
+  solver(LIPM::DOUBLING_SOLVER),
+  max_iterations(1000),
+  max_duration(0.0)
+{
+}
+
+void GainBank::set_solver(int solver, int max_iterations, double max_duration)
+{
+  this->solver = solver;
+  this->max_iterations = max_iterations;
+  this->max_duration = max_duration;
+}
+
+void GainBank::generate(
+  double time_step, const std::vector<double> & com_heights,
+  const std::vector<double> & com_periods, double preview_threshold)
+{
+  this->time_step = time_step;
+  this->preview_threshold = preview_threshold;
+  this->com_heights = com_heights;
+  this->com_periods = com_periods;
+
+  for (auto * axis : {&this->com_heights, &this->com_periods}) {
+    std::sort(axis->begin(), axis->end());
+    axis->erase(std::unique(axis->begin(), axis->end()), axis->end());
+  }
+
+  gains.clear();
+  for (double com_height : this->com_heights) {
+    for (double com_period : this->com_periods) {
+      LIPM lipm;
+      lipm.set_solver(solver, max_iterations, max_duration);
+      lipm.set_preview_threshold(preview_threshold);
+      lipm.set_parameters(com_height, time_step, com_period, com_period);
+
+      if (!lipm.get_dare_report().converged) {
+        std::cout << "DARE solver stopped before converging at com_height " << com_height
+                  << ", com_period " << com_period << std::endl;
+      }
+
+      auto grid_gains = Gains();
+      grid_gains.F = lipm.get_feedback_gain();
+      grid_gains.f = lipm.get_preview_gain();
+
+      gains.push_back(grid_gains);
+    }
+  }
+}
+
+bool GainBank::load(const std::string & path)
+{
+  std::ifstream bank_file(path);
+  if (!bank_file.is_open()) {
+    return false;
+  }
+
+  try {
+    nlohmann::json bank_data = nlohmann::json::parse(bank_file);
+
+    if (bank_data.at("version").get<int>() != GAIN_BANK_VERSION) {
+      std::cout << "Ignoring outdated gain bank `" << path << "`" << std::endl;
+      return false;
+    }
+
+    auto bank_heights = bank_data.at("com_heights").get<std::vector<double>>();
+    auto bank_periods = bank_data.at("com_periods").get<std::vector<double>>();
+    const auto & bank_gains = bank_data.at("gains");
+
+    if (
+      !is_increasing(bank_heights) || !is_increasing(bank_periods) ||
+      bank_gains.size() != bank_heights.size() * bank_periods.size()) {
+      std::cout << "Ignoring invalid gain bank `" << path << "`" << std::endl;
+      return false;
+    }
+
+    std::vector<Gains> loaded_gains;
+    for (const auto & entry : bank_gains) {
+      auto bank_F = entry.at("F").get<std::vector<double>>();
+
+      auto grid_gains = Gains();
+      grid_gains.f = entry.at("f").get<std::vector<double>>();
+
+      if (bank_F.size() != 4 || grid_gains.f.empty()) {
+        std::cout << "Ignoring invalid gain bank `" << path << "`" << std::endl;
+        return false;
+      }
+
+      for (size_t i = 0; i < 4; ++i) {
+        grid_gains.F[0][i] = bank_F[i];
+      }
+
+      loaded_gains.push_back(grid_gains);
+    }
+
+    time_step = bank_data.at("time_step").get<double>();
+    preview_threshold = bank_data.at("preview_threshold").get<double>();
+    com_heights = bank_heights;
+    com_periods = bank_periods;
+    gains = loaded_gains;
+  } catch (const nlohmann::json::exception &) {
+    std::cout << "Ignoring invalid gain bank `" << path << "`" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool GainBank::save(const std::string & path) const
+{
+  nlohmann::json bank_gains = nlohmann::json::array();
+  for (const auto & grid_gains : gains) {
+    std::vector<double> bank_F;
+    for (size_t i = 0; i < 4; ++i) {
+      bank_F.push_back(grid_gains.F[0][i]);
+    }
+
+    bank_gains.push_back({{"F", bank_F}, {"f", grid_gains.f}});
+  }
+
+  nlohmann::json bank_data = {
+    {"version", GAIN_BANK_VERSION},
+    {"time_step", time_step},
+    {"preview_threshold", preview_threshold},
+    {"com_heights", com_heights},
+    {"com_periods", com_periods},
+    {"gains", bank_gains}};
+
+  if (!write_json_atomically(path, bank_data)) {
+    std::cout << "Failed to write gain bank `" << path << "`" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool GainBank::interpolate(double com_height, double com_period, Gains & result) const
+{
+  size_t height_index;
+  size_t period_index;
+  double height_fraction;
+  double period_fraction;
+
+  if (
+    empty() || !find_cell(com_heights, com_height, height_index, height_fraction) ||
+    !find_cell(com_periods, com_period, period_index, period_fraction)) {
+    return false;
+  }
+
+  size_t next_height_index = std::min(height_index + 1, com_heights.size() - 1);
+  size_t next_period_index = std::min(period_index + 1, com_periods.size() - 1);
+
+  const Gains * corners[4] = {
+    &get_gains(height_index, period_index), &get_gains(height_index, next_period_index),
+    &get_gains(next_height_index, period_index), &get_gains(next_height_index, next_period_index)};
+
+  const double weights[4] = {
+    (1 - height_fraction) * (1 - period_fraction), (1 - height_fraction) * period_fraction,
+    height_fraction * (1 - period_fraction), height_fraction * period_fraction};
+
+  // Shorter horizons are zero padded, gains past a horizon do not act
+  size_t length = 0;
+  for (const auto * corner : corners) {
+    length = std::max(length, corner->f.size());
+  }
+
+  result.F = keisan::Matrix<1, 4>::zero();
+  result.f.assign(length, 0.0);
+
+  for (size_t corner = 0; corner < 4; ++corner) {
+    result.F += corners[corner]->F * weights[corner];
+
+    for (size_t i = 0; i < corners[corner]->f.size(); ++i) {
+      result.f[i] += corners[corner]->f[i] * weights[corner];
+    }
+  }
+
+  return true;
+}
+
+bool GainBank::is_increasing(const std::vector<double> & axis)
+{
+  if (axis.empty()) {
+    return false;
+  }
+
+  return std::adjacent_find(axis.begin(), axis.end(), std::greater_equal<double>()) == axis.end();
+}
+
+// Locate the grid cell holding the value, a single point axis only matches itself
+bool GainBank::find_cell(
+  const std::vector<double> & axis, double value, size_t & index, double & fraction)
+{
+  const double tolerance = 1e-9;
+
+  if (value < axis.front() - tolerance || value > axis.back() + tolerance) {
+    return false;
+  }
+
+  index = 0;
+  while (index + 2 < axis.size() && value > axis[index + 1]) {
+    index++;
+  }
+
+  fraction = 0.0;
+  if (axis.size() > 1) {
+    fraction = std::clamp((value - axis[index]) / (axis[index + 1] - axis[index]), 0.0, 1.0);
+  }
+
+  return true;
+}
+
+const GainBank::Gains & GainBank::get_gains(size_t height_index, size_t period_index) const
+{
+  return gains[height_index * com_periods.size() + period_index];
+}
+
+}  // namespace gankenkun
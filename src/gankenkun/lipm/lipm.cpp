@@ -20,31 +20,133 @@
 
 #include "gankenkun/lipm/lipm.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "gankenkun/utils/json_file.hpp"
+#include "nlohmann/json.hpp"
+
 namespace gankenkun
 {
 
-LIPM::LIPM() : dt(0.0), period(0.0), z(0.0) {}
+// Bump whenever the gain layout, the DARE weights or what is stored change
+static constexpr int GAIN_CACHE_VERSION = 3;
+static constexpr size_t GAIN_CACHE_ENTRIES = 16;
+
+// Cache entries are keyed on every parameter that changes the solved gains
+static bool is_same_gain_key(
+  const nlohmann::json & entry, double z, double dt, double period, double preview_threshold)
+{
+  return entry.at("com_height").get<double>() == z && entry.at("time_step").get<double>() == dt &&
+         entry.at("com_period").get<double>() == period &&
+         entry.at("preview_threshold").get<double>() == preview_threshold;
+}
+
+static LIPM::State to_state(const double values[3][2], const double control[2])
+{
+  auto state = LIPM::State();
+
+  state.position = keisan::Point2(values[0][0], values[0][1]);
+  state.velocity = keisan::Point2(values[1][0], values[1][1]);
+  state.acceleration = keisan::Point2(values[2][0], values[2][1]);
+  state.control = keisan::Point2(control[0], control[1]);
+
+  return state;
+}
+
+LIPM::LIPM()
+: dt(0.0),
+  period(0.0),
+  z(0.0),
+  start_tick(0),
+  sample(0),
+  single_precision(false),
+  solver(DOUBLING_SOLVER),
+  max_iterations(1000),
+  max_duration(0.0),
+  preview_threshold(0.0),
+  samples(0)
+{
+}
+
+std::unique_ptr<CenterOfMassGenerator> LIPM::clone() const
+{
+  return std::make_unique<LIPM>(*this);
+}
+
+void LIPM::set_solver(int solver, int max_iterations, double max_duration)
+{
+  this->solver = solver;
+  this->max_iterations = max_iterations;
+  this->max_duration = max_duration;
+}
 
-void LIPM::set_parameters(double z, double dt, double period)
+void LIPM::set_parameters(double z, double dt, double period, double max_step_duration)
 {
   this->z = z;
   this->dt = dt;
   this->period = period;
 
+  // Preallocate the trajectory for the longest planned step, update() only grows it for a longer
+  // one such as the far end of an idle plan, the streaming path never reads it
+  com_trajectory.reserve(static_cast<size_t>(round(std::max(max_step_duration, period) / dt)) + 1);
+
   initialize();
-  solve_dare();
+
+  dare_report = DAREReport();
+  if (!load_gains()) {
+    solve_dare();
+
+    // A solve cut short by its budget is not reused, a larger budget may finish it
+    if (dare_report.converged) {
+      save_gains();
+    }
+  }
+
+  kernel.set_model(A_d, B_d, C_d, F);
+  single_kernel.set_model(A_d, B_d, C_d, F);
+
+  store_gains();
+}
+
+void LIPM::set_gains(double z, double period, const GainBank::Gains & gains)
+{
+  this->z = z;
+  this->period = period;
+
+  // Only the ZMP projection depends on the COM height
+  C_d = keisan::Matrix<1, 3>(1.0, 0.0, -z / 9.8);
+
+  F = gains.F;
+  f = gains.f;
+
+  kernel.set_model(A_d, B_d, C_d, F);
+  single_kernel.set_model(A_d, B_d, C_d, F);
+
+  store_gains();
 }
 
 // Initialize the discrete-time LTI system matrices
 void LIPM::initialize()
 {
   // Initialize outputs
-  x_state = keisan::Matrix<3, 1>::zero();
-  y_state = keisan::Matrix<3, 1>::zero();
+  kernel.reset();
+  single_kernel.reset();
 
-  velocity.x = 0.0;
-  velocity.y = 0.0;
+  sample = 0;
+  samples = 0;
 
+  discretize(z, dt, A_d, B_d, C_d);
+}
+
+// Discrete-time cart-table model with the COM jerk as input and the ZMP as output
+void LIPM::discretize(
+  double z, double dt, keisan::Matrix<3, 3> & A_d, keisan::Matrix<3, 1> & B_d,
+  keisan::Matrix<1, 3> & C_d)
+{
   // Continuous-time system matrices
   auto A = keisan::Matrix<3, 3>(0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0);
 
@@ -67,10 +169,17 @@ void LIPM::initialize()
   C_d = C;
 }
 
+void LIPM::set_preview_threshold(double threshold) { preview_threshold = threshold; }
+
+void LIPM::set_single_precision(bool single_precision)
+{
+  this->single_precision = single_precision;
+}
+
 // Solve the discrete-time algebraic Riccati equation
 void LIPM::solve_dare()
 {
-  auto E_d = keisan::Matrix<3, 1>(dt, 1.0, 0.0);
+  auto start_time = std::chrono::steady_clock::now();
 
   auto CA_d = -C_d * A_d;
   auto Phai = keisan::Matrix<4, 4>(
@@ -87,33 +196,28 @@ void LIPM::solve_dare()
 
   auto H = keisan::Matrix<1, 1>(1.0);
 
-  // Iterative DARE solver
-  auto P = Qm;
+  dare_report = DAREReport();
 
-  const double tolerance = 1e-9;
-  const size_t max_iterations = 1000;
-
-  for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
-    auto P_prev = P;
+  if (solver == DOUBLING_SOLVER) {
+    solve_dare_doubling(Phai, G, Qm, H, start_time);
+  } else {
+    solve_dare_iterative(Phai, G, Qm, H, start_time);
+  }
 
+  // Relative residual of the Riccati equation at the returned solution
+  {
     auto GTP = G.transpose() * P;
-
     auto T = (H + GTP * G);
 
     if (T.inverse()) {
-      auto K = T * GTP * Phai;
-
-      P = Phai.transpose() * P * Phai - Phai.transpose() * P * G * K + Qm;
-
-      // Check for convergence
-      if ((P - P_prev).norm() < tolerance) {
-        break;
-      }
-    } else {
-      throw std::runtime_error("Failed to solve DARE equation!");
+      auto R = Phai.transpose() * P * Phai - Phai.transpose() * P * G * T * GTP * Phai + Qm - P;
+      dare_report.residual = R.norm() / std::max(P.norm(), 1.0);
     }
   }
 
+  dare_report.duration =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
   // Extract the feedback gain
   auto GTP = G.transpose() * P;
   auto T = (H + GTP * G);
@@ -124,75 +228,433 @@ void LIPM::solve_dare()
     throw std::runtime_error("Failed to extract feedback gain!");
   }
 
-  // Extract the preview gain
+  // Extract the preview gain, f[i] = -T * G^T * xiT^(i - 1) * P * GR with a running product
   auto I = keisan::Matrix<4, 4>::identity();
   auto xiT = ((I - G * T * GTP) * Phai).transpose();
 
-  for (int i = 0; i < static_cast<int>(round(period / dt)); i++) {
-    auto fi = (-T) * G.transpose() * xiT.power(i - 1) * P * GR;
+  auto TGT = (-T) * G.transpose();
+  auto xiTPGR = P * GR;
+
+  int horizon = static_cast<int>(round(period / dt));
+
+  f.clear();
+  for (int i = 0; i < horizon; i++) {
+    // A non-positive exponent yields the identity, so f[0] equals f[1]
+    if (i > 1) {
+      xiTPGR = xiT * xiTPGR;
+    }
+
+    auto fi = TGT * xiTPGR;
 
     f.push_back(fi[0][0]);
   }
+
+  // Drop the tail of gains that are negligible compared to the first one
+  if (preview_threshold > 0.0 && !f.empty()) {
+    double threshold = preview_threshold * std::abs(f.front());
+
+    size_t length = f.size();
+    while (length > 1 && std::abs(f[length - 1]) < threshold) {
+      length--;
+    }
+
+    f.resize(length);
+  }
 }
 
-// Update the LIPM state
-void LIPM::update(double time, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset)
+// Update the LIPM state for the whole step at once
+void LIPM::update(int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset)
+{
+  begin(tick, foot_steps, reset);
+
+  com_trajectory.clear();
+  while (sample < samples) {
+    com_trajectory.push_back(advance(foot_steps));
+  }
+}
+
+// Start streaming the LIPM state for a new step
+void LIPM::begin(int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, bool reset)
 {
   if (reset) {
-    velocity.x = 0.0;
-    velocity.y = 0.0;
+    kernel.reset_input();
+    single_kernel.reset_input();
   }
 
-  com_trajectory.clear();
-  auto next_x_state = x_state;
-  auto next_y_state = y_state;
+  start_tick = tick;
+  sample = 0;
+  samples = foot_steps[1].tick - tick;
+  fill_preview_ticks(tick, foot_steps, samples, preview_ticks);
 
-  for (int i = 0; i < static_cast<int>(round((foot_steps[1].time - time) / dt)); i++) {
-    auto projected_x = C_d * next_x_state;
-    auto projected_y = C_d * next_y_state;
+  kernel.restart();
+  single_kernel.restart();
+}
+
+// Only the preview ticks of the replaced footsteps are recomputed
+void LIPM::update_steps(
+  const std::deque<FootStepPlanner::FootStep> & foot_steps, size_t first_changed)
+{
+  int horizon = static_cast<int>(f.size());
+
+  size_t kept = first_changed > 0 ? first_changed - 1 : 0;
+  preview_ticks.resize(std::min(preview_ticks.size(), kept));
+  for (size_t index = preview_ticks.size() + 1; index < foot_steps.size(); ++index) {
+    int preview_tick = foot_steps[index].tick - start_tick;
+    if (preview_tick >= samples + horizon) {
+      break;
+    }
+
+    preview_ticks.push_back(preview_tick);
+  }
+}
 
-    auto error_x = foot_steps.front().position.x - projected_x[0][0];
-    auto error_y = foot_steps.front().position.y - projected_y[0][0];
+void LIPM::fill_preview_ticks(
+  int tick, const std::deque<FootStepPlanner::FootStep> & foot_steps, int samples,
+  std::vector<int> & ticks) const
+{
+  int horizon = static_cast<int>(f.size());
 
-    auto X = keisan::Matrix<4, 1>(
-      error_x, next_x_state[0][0] - x_state[0][0], next_x_state[1][0] - x_state[1][0],
-      next_x_state[2][0] - x_state[2][0]);
+  ticks.clear();
+  for (size_t index = 1; index < foot_steps.size(); ++index) {
+    int preview_tick = foot_steps[index].tick - tick;
+    if (preview_tick >= samples + horizon) {
+      break;
+    }
 
-    auto Y = keisan::Matrix<4, 1>(
-      error_y, next_y_state[0][0] - y_state[0][0], next_y_state[1][0] - y_state[1][0],
-      next_y_state[2][0] - y_state[2][0]);
+    ticks.push_back(preview_tick);
+  }
+}
 
-    x_state = next_x_state;
-    y_state = next_y_state;
+// Advance the LIPM state by a single sample, both axes at once
+LIPM::COMTrajectory LIPM::advance(const std::deque<FootStepPlanner::FootStep> & foot_steps)
+{
+  auto com = single_precision ? step(single_kernel, foot_steps, preview_ticks, sample)
+                              : step(kernel, foot_steps, preview_ticks, sample);
+
+  sample++;
 
-    auto dx = F * X;
-    auto dy = F * Y;
+  return com;
+}
+
+template <typename Scalar>
+LIPM::COMTrajectory LIPM::step(
+  LIPMKernel<Scalar> & kernel, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+  const std::vector<int> & ticks, int tick) const
+{
+  const double reference[2] = {foot_steps.front().position.x, foot_steps.front().position.y};
+  double projected[2];
+  double control[2];
+
+  kernel.feedback(reference, projected, control);
+  add_preview(foot_steps, ticks, tick, control);
+  kernel.integrate(control);
+
+  auto com = COMTrajectory();
+
+  com.position.x = kernel.get_position(0);
+  com.position.y = kernel.get_position(1);
+  com.velocity.x = kernel.get_velocity(0);
+  com.velocity.y = kernel.get_velocity(1);
+  com.projected_position.x = projected[0];
+  com.projected_position.y = projected[1];
+
+  return com;
+}
+
+LIPM::Evaluation LIPM::evaluate(
+  const std::deque<FootStepPlanner::FootStep> & foot_steps, const State & start) const
+{
+  if (single_precision) {
+    return evaluate(single_kernel, foot_steps, start);
+  }
+
+  return evaluate(kernel, foot_steps, start);
+}
+
+// Run every step of the sequence on a private copy of the kernel, the way the walking loop does
+template <typename Scalar>
+LIPM::Evaluation LIPM::evaluate(
+  LIPMKernel<Scalar> kernel, const std::deque<FootStepPlanner::FootStep> & foot_steps,
+  const State & start) const
+{
+  auto evaluation = Evaluation();
+
+  const double values[3][2] = {
+    {start.position.x, start.position.y},
+    {start.velocity.x, start.velocity.y},
+    {start.acceleration.x, start.acceleration.y}};
+  const double control[2] = {start.control.x, start.control.y};
+
+  kernel.set_state(values, control);
+
+  double sum_zmp_error = 0.0;
+
+  // The last step of a plan only pads the preview, the walking loop never steps onto it
+  std::deque<FootStepPlanner::FootStep> window(foot_steps);
+  while (window.size() > 2) {
+    int step_samples = window[1].tick - window[0].tick;
+    std::vector<int> ticks;
+    fill_preview_ticks(window[0].tick, window, step_samples, ticks);
+
+    kernel.restart();
+    for (int tick = 0; tick < step_samples; ++tick) {
+      auto com = step(kernel, window, ticks, tick);
+
+      double zmp_error = std::hypot(
+        com.projected_position.x - window.front().position.x,
+        com.projected_position.y - window.front().position.y);
+
+      evaluation.max_zmp_error = std::max(evaluation.max_zmp_error, zmp_error);
+      sum_zmp_error += zmp_error * zmp_error;
+
+      evaluation.com_trajectory.push_back(com);
+    }
+
+    window.pop_front();
+  }
+
+  if (!evaluation.com_trajectory.empty()) {
+    evaluation.rms_zmp_error = std::sqrt(sum_zmp_error / evaluation.com_trajectory.size());
+
+    const auto & com = evaluation.com_trajectory.back();
+    evaluation.final_com_error = std::hypot(
+      com.position.x - window.front().position.x, com.position.y - window.front().position.y);
+  }
+
+  double final_values[3][2];
+  double final_control[2];
+  kernel.get_state(final_values, final_control);
+
+  evaluation.final_state = to_state(final_values, final_control);
+
+  return evaluation;
+}
+
+// Fixed-point iteration of the Riccati recursion, converges linearly
+void LIPM::solve_dare_iterative(
+  const keisan::Matrix<4, 4> & Phai, const keisan::Matrix<4, 1> & G,
+  const keisan::Matrix<4, 4> & Qm, const keisan::Matrix<1, 1> & H,
+  const std::chrono::steady_clock::time_point & start_time)
+{
+  const double tolerance = 1e-9;
+
+  P = Qm;
+
+  while (!is_over_budget(start_time)) {
+    auto P_prev = P;
+
+    auto GTP = G.transpose() * P;
+
+    auto T = (H + GTP * G);
+
+    if (!T.inverse()) {
+      throw std::runtime_error("Failed to solve DARE equation!");
+    }
+
+    auto K = T * GTP * Phai;
+
+    P = Phai.transpose() * P * Phai - Phai.transpose() * P * G * K + Qm;
+    dare_report.iterations++;
+
+    // Check for convergence
+    if ((P - P_prev).norm() < tolerance) {
+      dare_report.converged = true;
+      break;
+    }
+  }
+}
+
+// Structure-preserving doubling algorithm, converges quadratically
+void LIPM::solve_dare_doubling(
+  const keisan::Matrix<4, 4> & Phai, const keisan::Matrix<4, 1> & G,
+  const keisan::Matrix<4, 4> & Qm, const keisan::Matrix<1, 1> & H,
+  const std::chrono::steady_clock::time_point & start_time)
+{
+  const double tolerance = 1e-12;
+
+  auto H_inverse = H;
+  if (!H_inverse.inverse()) {
+    throw std::runtime_error("Failed to solve DARE equation!");
+  }
+
+  auto I = keisan::Matrix<4, 4>::identity();
+
+  auto A_k = Phai;
+  auto G_k = G * H_inverse * G.transpose();
+  auto H_k = Qm;
+
+  while (!is_over_budget(start_time)) {
+    auto W = I + G_k * H_k;
+
+    if (!W.inverse()) {
+      throw std::runtime_error("Failed to solve DARE equation!");
+    }
+
+    auto A_next = A_k * W * A_k;
+    auto G_next = G_k + A_k * W * G_k * A_k.transpose();
+    auto H_next = H_k + A_k.transpose() * H_k * W * A_k;
+
+    dare_report.iterations++;
+
+    bool converged = (H_next - H_k).norm() <= tolerance * H_next.norm();
+
+    A_k = A_next;
+    G_k = G_next;
+    H_k = H_next;
+
+    if (converged) {
+      dare_report.converged = true;
+      break;
+    }
+  }
+
+  P = H_k;
+}
+
+bool LIPM::is_over_budget(const std::chrono::steady_clock::time_point & start_time) const
+{
+  if (dare_report.iterations >= max_iterations) {
+    return true;
+  }
+
+  if (max_duration > 0.0) {
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    return std::chrono::duration<double>(elapsed).count() >= max_duration;
+  }
+
+  return false;
+}
+
+// Load previously solved gains that match the current model parameters
+bool LIPM::load_gains()
+{
+  if (gain_cache_path.empty()) {
+    return false;
+  }
+
+  std::ifstream cache_file(gain_cache_path);
+  if (!cache_file.is_open()) {
+    return false;
+  }
+
+  try {
+    nlohmann::json cache_data = nlohmann::json::parse(cache_file);
+
+    if (cache_data.at("version").get<int>() != GAIN_CACHE_VERSION) {
+      return false;
+    }
+
+    for (const auto & entry : cache_data.at("entries")) {
+      if (!is_same_gain_key(entry, z, dt, period, preview_threshold)) {
+        continue;
+      }
+
+      auto cached_P = entry.at("P").get<std::vector<double>>();
+      auto cached_F = entry.at("F").get<std::vector<double>>();
+      auto cached_f = entry.at("f").get<std::vector<double>>();
 
-    size_t index = 1;
-    for (int j = 0; j < static_cast<int>(round(period / dt)); j++) {
       if (
-        static_cast<int>(round(i + j) + time / dt) >=
-        static_cast<int>(round(foot_steps[index].time / dt))) {
-        dx += f[j] * (foot_steps[index].position.x - foot_steps[index - 1].position.x);
-        dy += f[j] * (foot_steps[index].position.y - foot_steps[index - 1].position.y);
-        index++;
+        cached_P.size() != 16 || cached_F.size() != 4 ||
+        cached_f.empty() || cached_f.size() > static_cast<size_t>(round(period / dt))) {
+        return false;
+      }
+
+      for (size_t i = 0; i < 16; ++i) {
+        P[i / 4][i % 4] = cached_P[i];
       }
+
+      for (size_t i = 0; i < 4; ++i) {
+        F[0][i] = cached_F[i];
+      }
+
+      f = cached_f;
+
+      return true;
     }
+  } catch (const nlohmann::json::exception &) {
+    std::cout << "Ignoring invalid gain cache `" << gain_cache_path << "`" << std::endl;
+  }
+
+  return false;
+}
+
+// Store the solved gains, keeping the most recent parameter sets
+bool LIPM::save_gains() const
+{
+  if (gain_cache_path.empty() || !dare_report.converged) {
+    return false;
+  }
+
+  nlohmann::json entries = nlohmann::json::array();
+
+  std::ifstream cache_file(gain_cache_path);
+  if (cache_file.is_open()) {
+    try {
+      nlohmann::json cache_data = nlohmann::json::parse(cache_file);
+
+      if (cache_data.at("version").get<int>() == GAIN_CACHE_VERSION) {
+        for (const auto & entry : cache_data.at("entries")) {
+          if (!is_same_gain_key(entry, z, dt, period, preview_threshold)) {
+            entries.push_back(entry);
+          }
+        }
+      }
+    } catch (const nlohmann::json::exception &) {
+      entries.clear();
+    }
+
+    cache_file.close();
+  }
+
+  while (entries.size() >= GAIN_CACHE_ENTRIES) {
+    entries.erase(entries.begin());
+  }
+
+  std::vector<double> cached_P;
+  for (size_t i = 0; i < 16; ++i) {
+    cached_P.push_back(P[i / 4][i % 4]);
+  }
+
+  std::vector<double> cached_F;
+  for (size_t i = 0; i < 4; ++i) {
+    cached_F.push_back(F[0][i]);
+  }
 
-    velocity.x += dx[0][0];
-    velocity.y += dy[0][0];
+  entries.push_back(
+    {{"com_height", z},
+     {"time_step", dt},
+     {"com_period", period},
+     {"preview_threshold", preview_threshold},
+     {"P", cached_P},
+     {"F", cached_F},
+     {"f", f}});
 
-    next_x_state = A_d * x_state + B_d * velocity.x;
-    next_y_state = A_d * y_state + B_d * velocity.y;
+  nlohmann::json cache_data = {{"version", GAIN_CACHE_VERSION}, {"entries", entries}};
 
-    auto com = COMTrajectory();
+  if (!write_json_atomically(gain_cache_path, cache_data)) {
+    std::cout << "Failed to write gain cache `" << gain_cache_path << "`" << std::endl;
+    return false;
+  }
+
+  return true;
+}
 
-    com.position.x = next_x_state[0][0];
-    com.position.y = next_y_state[0][0];
-    com.projected_position.x = projected_x[0][0];
-    com.projected_position.y = projected_y[0][0];
+// The ZMP reference only changes at footstep transitions
+void LIPM::add_preview(
+  const std::deque<FootStepPlanner::FootStep> & foot_steps, const std::vector<int> & ticks,
+  int tick, double control[2]) const
+{
+  int horizon = static_cast<int>(f.size());
 
-    com_trajectory.push_back(com);
+  int j = -1;
+  for (size_t index = 1; index <= ticks.size(); ++index) {
+    j = std::max(ticks[index - 1] - tick, j + 1);
+    if (j >= horizon) {
+      break;
+    }
+
+    control[0] += f[j] * (foot_steps[index].position.x - foot_steps[index - 1].position.x);
+    control[1] += f[j] * (foot_steps[index].position.y - foot_steps[index - 1].position.y);
   }
 }
 
@@ -205,4 +667,38 @@ LIPM::COMTrajectory LIPM::pop_front()
   return com;
 }
 
+void LIPM::skip_sample(const COMTrajectory &) { sample++; }
+
+LIPM::State LIPM::get_state() const
+{
+  double values[3][2];
+  double control[2];
+
+  if (single_precision) {
+    single_kernel.get_state(values, control);
+  } else {
+    kernel.get_state(values, control);
+  }
+
+  return to_state(values, control);
+}
+
+void LIPM::set_state(const State & state)
+{
+  const double values[3][2] = {
+    {state.position.x, state.position.y},
+    {state.velocity.x, state.velocity.y},
+    {state.acceleration.x, state.acceleration.y}};
+  const double control[2] = {state.control.x, state.control.y};
+
+  kernel.set_state(values, control);
+  single_kernel.set_state(values, control);
+}
+
+// Check whether the COM has come to rest
+bool LIPM::is_settled(double tolerance) const
+{
+  return single_precision ? single_kernel.is_settled(tolerance) : kernel.is_settled(tolerance);
+}
+
 }  // namespace gankenkun
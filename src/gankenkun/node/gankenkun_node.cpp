@@ -22,26 +22,26 @@
 
 #include <chrono>
 
-using namespace std::chrono_literals;
-
 namespace gankenkun
 {
 
 GankenkunNode::GankenkunNode(const rclcpp::Node::SharedPtr & node)
 : node(node), walking_manager(nullptr), walking_node(nullptr), config_node(nullptr)
 {
-  node_timer = node->create_wall_timer(8ms, [this]() {
-    if (this->walking_manager && walking_node) {
-      this->walking_manager->process();
-      this->walking_node->update();
-    }
-  });
 }
 
 void GankenkunNode::set_walking_manager(const std::shared_ptr<WalkingManager> & walking_manager)
 {
   this->walking_manager = walking_manager;
   walking_node = std::make_shared<WalkingNode>(node, walking_manager);
+
+  // Joints are solved at the servo rate of the loaded config, a new period needs a restart
+  auto servo_period = std::chrono::duration<double>(walking_manager->get_servo_period());
+  node_timer = node->create_wall_timer(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(servo_period), [this]() {
+      this->walking_manager->process();
+      this->walking_node->update();
+    });
 }
 
 void GankenkunNode::run_config_service(const std::string & path)
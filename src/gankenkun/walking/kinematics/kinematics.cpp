@@ -20,6 +20,9 @@
 
 #include "gankenkun/walking/kinematics/kinematics.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "jitsuyo/config.hpp"
 #include "tachimawari/joint/model/joint.hpp"
 #include "tachimawari/joint/model/joint_id.hpp"
@@ -33,7 +36,8 @@ Kinematics::Kinematics()
   knee_length(0.0),
   thigh_length(0.0),
   x_offset(0.0),
-  y_offset(0.0)
+  y_offset(0.0),
+  single_precision(false)
 {
   reset_angles();
 }
@@ -87,42 +91,33 @@ void Kinematics::set_config(const nlohmann::json & kinematic_data)
   }
 }
 
+void Kinematics::set_single_precision(bool single_precision)
+{
+  this->single_precision = single_precision;
+}
+
 void Kinematics::solve_inverse_kinematics(const Foot & left_foot, const Foot & right_foot)
 {
   using tachimawari::joint::JointId;
 
+  double leg_length = ankle_length + calf_length + knee_length + thigh_length;
+
   double left_x = left_foot.position.x - x_offset;
   double left_y = left_foot.position.y - y_offset;
-  double left_z = ankle_length + calf_length + knee_length + thigh_length - left_foot.position.z;
+  double left_z = leg_length - left_foot.position.z;
 
-  double left_x2 = left_x * left_foot.yaw.cos() + left_y * left_foot.yaw.sin();
-  double left_y2 = -left_x * left_foot.yaw.sin() + left_y * left_foot.yaw.cos();
-  double left_z2 = left_z - ankle_length;
-
-  // Hip roll angle
-  keisan::Angle<double> hip_roll = keisan::signed_arctan(left_y2, left_z2);
-
-  double left2 = left_y2 * left_y2 + left_z2 * left_z2;
-  double left_z3 = std::sqrt(std::max(0.0, left2 - left_x2 * left_x2)) - knee_length;
-
-  keisan::Angle<double> pitch = keisan::signed_arctan(left_x2, left_z3);
-  double length = std::hypot(left_x2, left_z3);
-  keisan::Angle<double> knee_disp =
-    keisan::arccos(keisan::clamp(length / (2.0 * thigh_length), -1.0, 1.0));
-
-  // Hip pitch angle
-  keisan::Angle<double> hip_pitch = -pitch - knee_disp;
-
-  // Knee pitch angle
-  keisan::Angle<double> knee_pitch = -pitch + knee_disp;
+  auto left_leg = single_precision
+                    ? solve_leg<float>(left_x, left_y, left_z, left_foot.yaw.radian())
+                    : solve_leg<double>(left_x, left_y, left_z, left_foot.yaw.radian());
 
   angles[JointId::LEFT_HIP_YAW] = left_foot.yaw;
-  angles[JointId::LEFT_HIP_ROLL] = hip_roll;
-  angles[JointId::LEFT_HIP_PITCH] = -hip_pitch;
-  angles[JointId::LEFT_UPPER_KNEE] = hip_pitch;
-  angles[JointId::LEFT_LOWER_KNEE] = -knee_pitch;
-  angles[JointId::LEFT_ANKLE_PITCH] = 0.0_deg;   // TODO: Add offset from param left_foot pitch
-  angles[JointId::LEFT_ANKLE_ROLL] = -hip_roll;  // TODO: Add offset from param left_foot roll
+  angles[JointId::LEFT_HIP_ROLL] = keisan::make_radian(left_leg.hip_roll);
+  angles[JointId::LEFT_HIP_PITCH] = keisan::make_radian(-left_leg.hip_pitch);
+  angles[JointId::LEFT_UPPER_KNEE] = keisan::make_radian(left_leg.hip_pitch);
+  angles[JointId::LEFT_LOWER_KNEE] = keisan::make_radian(-left_leg.knee_pitch);
+  angles[JointId::LEFT_ANKLE_PITCH] = 0.0_deg;  // TODO: Add offset from param left_foot pitch
+  angles[JointId::LEFT_ANKLE_ROLL] =
+    keisan::make_radian(-left_leg.hip_roll);  // TODO: Add offset from param left_foot roll
 
   // std::cout << "Left Hip Yaw: " << angles[JointId::LEFT_HIP_YAW].degree() << std::endl;
   // std::cout << "Left Hip Roll: " << angles[JointId::LEFT_HIP_ROLL].degree() << std::endl;
@@ -134,35 +129,20 @@ void Kinematics::solve_inverse_kinematics(const Foot & left_foot, const Foot & r
 
   double right_x = right_foot.position.x - x_offset;
   double right_y = right_foot.position.y + y_offset;
-  double right_z = ankle_length + calf_length + knee_length + thigh_length - right_foot.position.z;
+  double right_z = leg_length - right_foot.position.z;
 
-  double right_x2 = right_x * right_foot.yaw.cos() + right_y * right_foot.yaw.sin();
-  double right_y2 = -right_x * right_foot.yaw.sin() + right_y * right_foot.yaw.cos();
-  double right_z2 = right_z - ankle_length;
-
-  // Hip roll angle
-  hip_roll = keisan::signed_arctan(right_y2, right_z2);
-
-  double right2 = right_y2 * right_y2 + right_z2 * right_z2;
-  double right_z3 = std::sqrt(std::max(0.0, right2 - right_x2 * right_x2)) - knee_length;
-
-  pitch = keisan::signed_arctan(right_x2, right_z3);
-  length = std::hypot(right_x2, right_z3);
-  knee_disp = keisan::arccos(keisan::clamp(length / (2.0 * thigh_length), -1.0, 1.0));
-
-  // Hip pitch angle
-  hip_pitch = -pitch - knee_disp;
-
-  // Knee pitch angle
-  knee_pitch = -pitch + knee_disp;
+  auto right_leg = single_precision
+                     ? solve_leg<float>(right_x, right_y, right_z, right_foot.yaw.radian())
+                     : solve_leg<double>(right_x, right_y, right_z, right_foot.yaw.radian());
 
   angles[JointId::RIGHT_HIP_YAW] = right_foot.yaw;
-  angles[JointId::RIGHT_HIP_ROLL] = hip_roll;
-  angles[JointId::RIGHT_HIP_PITCH] = hip_pitch;
-  angles[JointId::RIGHT_UPPER_KNEE] = -hip_pitch;
-  angles[JointId::RIGHT_LOWER_KNEE] = -knee_pitch;
-  angles[JointId::RIGHT_ANKLE_PITCH] = 0.0_deg;   // TODO: Add offset from param right_foot pitch
-  angles[JointId::RIGHT_ANKLE_ROLL] = -hip_roll;  // TODO: Add offset from param right_foot roll
+  angles[JointId::RIGHT_HIP_ROLL] = keisan::make_radian(right_leg.hip_roll);
+  angles[JointId::RIGHT_HIP_PITCH] = keisan::make_radian(right_leg.hip_pitch);
+  angles[JointId::RIGHT_UPPER_KNEE] = keisan::make_radian(-right_leg.hip_pitch);
+  angles[JointId::RIGHT_LOWER_KNEE] = keisan::make_radian(-right_leg.knee_pitch);
+  angles[JointId::RIGHT_ANKLE_PITCH] = 0.0_deg;  // TODO: Add offset from param right_foot pitch
+  angles[JointId::RIGHT_ANKLE_ROLL] =
+    keisan::make_radian(-right_leg.hip_roll);  // TODO: Add offset from param right_foot roll
 
   // std::cout << "Right Hip Yaw: " << angles[JointId::RIGHT_HIP_YAW].degree() << std::endl;
   // std::cout << "Right Hip Roll: " << angles[JointId::RIGHT_HIP_ROLL].degree() << std::endl;
@@ -173,4 +153,48 @@ void Kinematics::solve_inverse_kinematics(const Foot & left_foot, const Foot & r
   // std::cout << "Right Ankle Roll: " << angles[JointId::RIGHT_ANKLE_ROLL].degree() << std::endl;
 }
 
+// Solve a single leg in the given precision, the result is widened back to double
+template <typename Scalar>
+Kinematics::LegAngles Kinematics::solve_leg(double x, double y, double z, double yaw) const
+{
+  Scalar foot_x = static_cast<Scalar>(x);
+  Scalar foot_y = static_cast<Scalar>(y);
+  Scalar foot_z = static_cast<Scalar>(z);
+  Scalar foot_yaw = static_cast<Scalar>(yaw);
+
+  Scalar x2 = foot_x * std::cos(foot_yaw) + foot_y * std::sin(foot_yaw);
+  Scalar y2 = -foot_x * std::sin(foot_yaw) + foot_y * std::cos(foot_yaw);
+  Scalar z2 = foot_z - static_cast<Scalar>(ankle_length);
+
+  // Hip roll angle
+  Scalar hip_roll = std::atan2(y2, z2);
+
+  Scalar leg2 = y2 * y2 + z2 * z2;
+  Scalar z3 =
+    std::sqrt(std::max(static_cast<Scalar>(0), leg2 - x2 * x2)) - static_cast<Scalar>(knee_length);
+
+  Scalar pitch = std::atan2(x2, z3);
+  Scalar length = std::hypot(x2, z3);
+  Scalar knee_disp = std::acos(std::clamp(
+    length / (static_cast<Scalar>(2) * static_cast<Scalar>(thigh_length)), static_cast<Scalar>(-1),
+    static_cast<Scalar>(1)));
+
+  LegAngles leg;
+
+  leg.hip_roll = hip_roll;
+
+  // Hip pitch angle
+  leg.hip_pitch = -pitch - knee_disp;
+
+  // Knee pitch angle
+  leg.knee_pitch = -pitch + knee_disp;
+
+  return leg;
+}
+
+template Kinematics::LegAngles Kinematics::solve_leg<float>(
+  double x, double y, double z, double yaw) const;
+template Kinematics::LegAngles Kinematics::solve_leg<double>(
+  double x, double y, double z, double yaw) const;
+
 }  // namespace gankenkun
@@ -20,8 +20,11 @@
 
 #include "gankenkun/walking/node/walking_manager.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
+#include "gankenkun/com/dcm.hpp"
 #include "jitsuyo/config.hpp"
 
 using namespace keisan::literals;
@@ -30,12 +33,26 @@ namespace gankenkun
 {
 
 WalkingManager::WalkingManager()
-: initialized(false),
+: pending_command(NO_COMMAND),
+  pending_position(keisan::Point2(0.0, 0.0)),
+  pending_orientation(0.0_deg),
+  stop_requested(false),
+  stop_request_time(0),
+  stop_measuring(false),
+  stop_start_time(0),
+  search_max_duration(0.01),
+  search_max_zmp_error(0.0),
+  initialized(false),
+  configured(false),
+  idle(false),
   left_up(0.0),
   right_up(0.0),
   robot_position(keisan::Point2(0.0, 0.0)),
   robot_orientation(0.0_deg),
   time_step(0.008),
+  servo_period(0.008),
+  interpolation_steps(1),
+  interpolation_step(0),
   status(FootStepPlanner::START),
   next_support(FootStepPlanner::RIGHT_FOOT),
   dsp_duration(0.0),
@@ -48,7 +65,36 @@ WalkingManager::WalkingManager()
   step_y_offset(0.0),
   odometry_offset(keisan::Point2(0.0, 0.0)),
   max_stride(keisan::Point2(0.0, 0.0)),
-  max_rotation(0.0_deg)
+  max_rotation(0.0_deg),
+  com_generator_type(PREVIEW_GENERATOR),
+  com_generator(std::make_unique<LIPM>()),
+  lipm(nullptr),
+  mpc(nullptr),
+  dare_solver(LIPM::DOUBLING_SOLVER),
+  dare_max_iterations(1000),
+  dare_max_duration(0.0),
+  preview_threshold(0.0),
+  lipm_single_precision(false),
+  segments_enabled(false),
+  pose_tick(0),
+  mpc_horizon(0.0),
+  mpc_max_iterations(50),
+  mpc_max_duration(0.0),
+  mpc_zmp_margin(0.02),
+  target_com_height(0.0),
+  target_com_period(0.0),
+  height_offset(0.0),
+  height_offset_delta(0.0),
+  height_offset_target(0.0),
+  memo_enabled(false),
+  memo_resolution(1e-4),
+  memo_state_resolution(5e-3),
+  memo_mode(MEMO_NONE),
+  memo_replay(nullptr),
+  memo_sample(0),
+  memo_tick(0),
+  memo_origin(keisan::Point2(0.0, 0.0)),
+  memo_rotation(0.0)
 {
   using tachimawari::joint::Joint;
   using tachimawari::joint::JointId;
@@ -66,6 +112,8 @@ void WalkingManager::load_config(const std::string & path)
   std::ifstream kinematic_file(path + "kinematic.json");
   nlohmann::json kinematic_data = nlohmann::json::parse(kinematic_file);
 
+  gain_cache_path = path + "lipm_gains.json";
+  gain_bank_path = path + "lipm_gain_bank.json";
   set_config(walking_data, kinematic_data);
 
   walking_file.close();
@@ -77,8 +125,15 @@ void WalkingManager::load_config(const std::string & path)
 void WalkingManager::set_config(
   const nlohmann::json & walking_data, const nlohmann::json & kinematic_data)
 {
+  // Called from the config service while commands may arrive, locked in the set_goal() order
+  std::lock_guard<std::mutex> search_lock(search_mutex);
+  std::lock_guard<std::mutex> lock(mutex);
+
   bool valid_config = true;
 
+  double previous_time_step = time_step;
+  double previous_servo_period = servo_period;
+
   nlohmann::json timing_section;
   if (jitsuyo::assign_val(walking_data, "timing", timing_section)) {
     bool valid_section = true;
@@ -88,6 +143,33 @@ void WalkingManager::set_config(
     valid_section &= jitsuyo::assign_val(timing_section, "com_period", com_period);
     valid_section &= jitsuyo::assign_val(timing_section, "step_frames", step_frames);
 
+    // Optional, the LIPM and the joints run at the same 8 ms rate when they are missing
+    time_step = 0.008;
+    jitsuyo::assign_val(timing_section, "time_step", time_step);
+
+    servo_period = time_step;
+    jitsuyo::assign_val(timing_section, "servo_period", servo_period);
+
+    // The servo timer keeps the rate of the first config, a new rate needs a restart
+    if (
+      configured && (std::abs(time_step - previous_time_step) > 1e-9 ||
+                     std::abs(servo_period - previous_servo_period) > 1e-9)) {
+      std::cout << "Ignoring new `time_step` and `servo_period`, changing the servo rate needs "
+                << "a restart" << std::endl;
+
+      time_step = previous_time_step;
+      servo_period = previous_servo_period;
+    }
+
+    // The LIPM time step has to be a whole number of servo periods
+    valid_section &= time_step > 0.0 && servo_period > 0.0;
+    if (valid_section) {
+      interpolation_steps = std::max(static_cast<int>(round(time_step / servo_period)), 1);
+      valid_section &= std::abs(interpolation_steps * servo_period - time_step) < 1e-9;
+    }
+
+    interpolation_step = 0;
+
     if (!valid_section) {
       std::cout << "Error found at section `timing`" << std::endl;
       valid_config = false;
@@ -151,15 +233,299 @@ void WalkingManager::set_config(
     valid_config = false;
   }
 
+  // Optional, the preview controller is used when it is missing
+  std::string generator = "preview";
+  jitsuyo::assign_val(walking_data, "com_generator", generator);
+
+  if (generator == "preview") {
+    com_generator_type = PREVIEW_GENERATOR;
+  } else if (generator == "dcm") {
+    com_generator_type = DCM_GENERATOR;
+  } else if (generator == "mpc") {
+    com_generator_type = MPC_GENERATOR;
+  } else {
+    std::cout << "Error found at `com_generator`" << std::endl;
+    valid_config = false;
+  }
+
+  // Optional section, the defaults are kept when it is missing
+  nlohmann::json lipm_section;
+  if (jitsuyo::assign_val(walking_data, "lipm", lipm_section)) {
+    bool valid_section = true;
+
+    std::string solver = "doubling";
+
+    jitsuyo::assign_val(lipm_section, "solver", solver);
+    jitsuyo::assign_val(lipm_section, "max_iterations", dare_max_iterations);
+    jitsuyo::assign_val(lipm_section, "max_duration", dare_max_duration);
+    jitsuyo::assign_val(lipm_section, "preview_threshold", preview_threshold);
+
+    if (solver == "doubling") {
+      dare_solver = LIPM::DOUBLING_SOLVER;
+    } else if (solver == "iterative") {
+      dare_solver = LIPM::ITERATIVE_SOLVER;
+    } else {
+      valid_section = false;
+    }
+
+    if (!valid_section) {
+      std::cout << "Error found at section `lipm`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Optional section, the planner keeps just enough steps for the COM preview when it is missing
+  int planner_window = 0;
+  nlohmann::json planner_section;
+  if (jitsuyo::assign_val(walking_data, "planner", planner_section)) {
+    bool valid_section = true;
+
+    jitsuyo::assign_val(planner_section, "window", planner_window);
+
+    valid_section &= planner_window >= 0;
+
+    if (!valid_section) {
+      std::cout << "Error found at section `planner`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Optional section, obstacles are only searched around once some are set
+  nlohmann::json search_section;
+  double search_clearance = 0.1;
+  double search_initial_weight = 3.0;
+  double search_weight_step = 0.5;
+  int search_max_nodes = 50000;
+  int search_threads = 0;
+  search_max_duration = 0.01;
+  search_max_zmp_error = 0.0;
+  if (jitsuyo::assign_val(walking_data, "search", search_section)) {
+    bool valid_section = true;
+
+    jitsuyo::assign_val(search_section, "clearance", search_clearance);
+    jitsuyo::assign_val(search_section, "initial_weight", search_initial_weight);
+    jitsuyo::assign_val(search_section, "weight_step", search_weight_step);
+    jitsuyo::assign_val(search_section, "max_nodes", search_max_nodes);
+    jitsuyo::assign_val(search_section, "max_duration", search_max_duration);
+    jitsuyo::assign_val(search_section, "max_zmp_error", search_max_zmp_error);
+    jitsuyo::assign_val(search_section, "threads", search_threads);
+
+    valid_section &= search_clearance >= 0.0 && search_initial_weight >= 1.0 &&
+                     search_weight_step > 0.0 && search_max_nodes > 0 &&
+                     search_max_zmp_error >= 0.0 && search_threads >= 0;
+
+    if (!valid_section) {
+      std::cout << "Error found at section `search`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Optional section, the COM is only kept as samples when it is missing. Only the DCM generator
+  // has a closed form per step, the preview controller and the MPC solve a new jerk every sample
+  // so their segments would be the same Hermite cubics the joints already interpolate with
+  nlohmann::json segments_section;
+  segments_enabled = false;
+  if (jitsuyo::assign_val(walking_data, "segments", segments_section)) {
+    bool valid_section = true;
+
+    double segments_tolerance = 1e-6;
+    int segments_capacity = 1024;
+
+    jitsuyo::assign_val(segments_section, "enabled", segments_enabled);
+    jitsuyo::assign_val(segments_section, "tolerance", segments_tolerance);
+    jitsuyo::assign_val(segments_section, "capacity", segments_capacity);
+
+    valid_section &= segments_tolerance >= 0.0 && segments_capacity > 0;
+
+    if (segments_enabled && com_generator_type != DCM_GENERATOR) {
+      std::cout << "COM segments need the `dcm` generator" << std::endl;
+      valid_section = false;
+    }
+
+    com_segments.set_tolerance(segments_tolerance);
+    com_segments.set_capacity(std::max(segments_capacity, 1));
+
+    if (!valid_section) {
+      std::cout << "Error found at section `segments`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  com_segments.clear();
+
+  // Optional section, the MPC previews as far as the LIPM and gets half a time step per tick
+  nlohmann::json mpc_section;
+  mpc_horizon = com_period;
+  mpc_max_iterations = 50;
+  mpc_max_duration = time_step / 2;
+  mpc_zmp_margin = 0.02;
+  if (jitsuyo::assign_val(walking_data, "mpc", mpc_section)) {
+    bool valid_section = true;
+
+    jitsuyo::assign_val(mpc_section, "horizon", mpc_horizon);
+    jitsuyo::assign_val(mpc_section, "max_iterations", mpc_max_iterations);
+    jitsuyo::assign_val(mpc_section, "max_duration", mpc_max_duration);
+    jitsuyo::assign_val(mpc_section, "zmp_margin", mpc_zmp_margin);
+
+    valid_section &= mpc_horizon > 0.0 && mpc_max_iterations > 0 && mpc_zmp_margin > 0.0;
+
+    if (!valid_section) {
+      std::cout << "Error found at section `mpc`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Optional section, both paths stay in double precision when it is missing
+  nlohmann::json precision_section;
+  if (jitsuyo::assign_val(walking_data, "precision", precision_section)) {
+    bool valid_section = true;
+
+    std::string lipm_precision = "double";
+    std::string kinematics_precision = "double";
+
+    jitsuyo::assign_val(precision_section, "lipm", lipm_precision);
+    jitsuyo::assign_val(precision_section, "kinematics", kinematics_precision);
+
+    valid_section &= lipm_precision == "single" || lipm_precision == "double";
+    valid_section &= kinematics_precision == "single" || kinematics_precision == "double";
+
+    lipm_single_precision = lipm_precision == "single";
+    kinematics.set_single_precision(kinematics_precision == "single");
+
+    if (!valid_section) {
+      std::cout << "Error found at section `precision`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Optional section, steps are always recomputed when it is missing
+  nlohmann::json memo_section;
+  memo_enabled = false;
+  if (jitsuyo::assign_val(walking_data, "memo", memo_section)) {
+    bool valid_section = true;
+
+    int memo_capacity = 64;
+
+    jitsuyo::assign_val(memo_section, "enabled", memo_enabled);
+    jitsuyo::assign_val(memo_section, "resolution", memo_resolution);
+    jitsuyo::assign_val(memo_section, "state_resolution", memo_state_resolution);
+    jitsuyo::assign_val(memo_section, "capacity", memo_capacity);
+
+    valid_section &= memo_resolution > 0.0 && memo_state_resolution > 0.0 && memo_capacity >= 0;
+
+    memo.set_capacity(std::max(memo_capacity, 0));
+
+    if (!valid_section) {
+      std::cout << "Error found at section `memo`" << std::endl;
+      valid_config = false;
+    }
+  }
+
+  // Cached steps were produced with the old parameters
+  memo.clear();
+  memo_mode = MEMO_NONE;
+  memo_replay = nullptr;
+
   if (!valid_config) {
     throw std::runtime_error("Failed to load config file `walking.json`");
   }
 
-  foot_step_planner.set_parameters(max_stride, max_rotation, plan_period, step_y_offset);
+  foot_step_planner.set_parameters(
+    max_stride, max_rotation, plan_period, step_y_offset, time_step);
 
-  lipm.set_parameters(com_height, time_step, com_period);
+  foot_step_search.set_parameters(max_stride, max_rotation, search_clearance);
+  foot_step_search.set_weights(search_initial_weight, search_weight_step);
+  foot_step_search.set_max_nodes(std::max(search_max_nodes, 1));
+
+  // Zero threads uses every hardware thread
+  search_evaluator.reset();
+  if (search_max_zmp_error > 0.0) {
+    search_evaluator = std::make_unique<BatchEvaluator>(search_threads);
+  }
+
+  // A bank is only usable when it was generated for the same time step and truncation
+  gain_bank = GainBank();
+  if (!gain_bank_path.empty() && gain_bank.load(gain_bank_path)) {
+    if (
+      std::abs(gain_bank.get_time_step() - time_step) > 1e-9 ||
+      gain_bank.get_preview_threshold() != preview_threshold) {
+      std::cout << "Ignoring gain bank generated for another time step or preview threshold"
+                << std::endl;
+      gain_bank = GainBank();
+    }
+  }
+
+  // The preview may switch to any period of the bank between steps
+  double preview_period = com_period;
+  if (com_generator_type == PREVIEW_GENERATOR) {
+    preview_period = std::max(preview_period, gain_bank.get_max_period());
+  }
+
+  // The support step, up to two periods of the current step, the steps inside the preview and
+  // the first one after it, steps are at least a period apart
+  double lookahead = std::max(preview_period, mpc_horizon);
+  int preview_window = 3 + static_cast<int>(std::ceil(lookahead / plan_period - 1e-9));
+  foot_step_planner.set_window(std::max(planner_window, preview_window));
+
+  target_com_height = com_height;
+  target_com_period = com_period;
+  height_offset = 0.0;
+  height_offset_delta = 0.0;
+  height_offset_target = 0.0;
+
+  if (com_generator_type == DCM_GENERATOR) {
+    auto dcm = std::make_unique<DCM>();
+    dcm->set_parameters(com_height, time_step);
+
+    com_generator = std::move(dcm);
+    lipm = nullptr;
+    mpc = nullptr;
+  } else if (com_generator_type == MPC_GENERATOR) {
+    auto predictive = std::make_unique<MPC>();
+    predictive->set_solver(mpc_max_iterations, mpc_max_duration);
+    predictive->set_zmp_margin(mpc_zmp_margin);
+    predictive->set_parameters(com_height, time_step, mpc_horizon);
+
+    mpc = predictive.get();
+    com_generator = std::move(predictive);
+    lipm = nullptr;
+  } else {
+    // The double support steps at the start and the end of a plan are the longest ones
+    // Use a compile-time specialized LIPM when the timing matches one of its profiles,
+    // the preview horizon of a gain bank may change between steps so it needs the runtime one
+    auto preview = gain_bank.empty() ? make_lipm(time_step, com_period) : std::make_unique<LIPM>();
+    preview->set_gain_cache(gain_cache_path);
+    preview->set_solver(dare_solver, dare_max_iterations, dare_max_duration);
+    preview->set_preview_threshold(preview_threshold);
+    preview->set_single_precision(lipm_single_precision);
+    preview->set_parameters(com_height, time_step, com_period, plan_period * 2);
+    preview->reserve_preview(std::max(planner_window, preview_window));
+
+    const auto & dare_report = preview->get_dare_report();
+    if (dare_report.iterations > 0) {
+      std::cout << "DARE solved in " << dare_report.iterations << " iterations ("
+                << dare_report.duration * 1e3 << " ms, residual " << dare_report.residual << ")"
+                << std::endl;
+
+      if (!dare_report.converged) {
+        std::cout << "DARE solver stopped before converging!" << std::endl;
+      }
+    }
+
+    int horizon = static_cast<int>(round(com_period / time_step));
+    if (preview->get_preview_length() < horizon) {
+      std::cout << "Preview horizon truncated to " << preview->get_preview_length() << " of "
+                << horizon << " samples" << std::endl;
+    }
+
+    lipm = preview.get();
+    mpc = nullptr;
+    com_generator = std::move(preview);
+  }
 
   kinematics.set_config(kinematic_data);
+
+  configured = true;
 }
 
 void WalkingManager::set_position(const keisan::Point2 & position) { robot_position = position; }
@@ -169,29 +535,372 @@ void WalkingManager::set_orientation(const keisan::Angle<double> & orientation)
   robot_orientation = orientation;
 }
 
+bool WalkingManager::set_com_target(double com_height, double com_period)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Only the preview controller has its gains banked
+  GainBank::Gains gains;
+  if (!lipm || !gain_bank.interpolate(com_height, com_period, gains)) {
+    return false;
+  }
+
+  target_com_height = com_height;
+  target_com_period = com_period;
+
+  return true;
+}
+
+// Switch the LIPM gains at a step boundary and lower or raise the hip over the coming step
+void WalkingManager::update_com_target()
+{
+  if (!lipm || (target_com_height == lipm->z && target_com_period == lipm->period)) {
+    return;
+  }
+
+  GainBank::Gains gains;
+  if (!gain_bank.interpolate(target_com_height, target_com_period, gains)) {
+    return;
+  }
+
+  lipm->set_gains(target_com_height, target_com_period, gains);
+
+  // A lower COM bends the legs, moving the feet up towards the hip
+  height_offset_target = com_height - target_com_height;
+}
+
 bool WalkingManager::is_running() { return status == FootStepPlanner::WALKING; }
 
-void WalkingManager::stop() { set_goal(robot_position, robot_orientation); }
+// The plan is drained down to the trailing double support steps and the COM is at rest
+bool WalkingManager::is_standing() const
+{
+  const auto & foot_steps = foot_step_planner.foot_steps;
+
+  return foot_steps.size() <= 3 && foot_steps[0].support_foot == FootStepPlanner::BOTH_FEET &&
+         foot_steps[1].support_foot == FootStepPlanner::BOTH_FEET && com_generator->is_settled();
+}
+
+void WalkingManager::stop()
+{
+  stop_request_time = std::chrono::steady_clock::now().time_since_epoch().count();
+  stop_requested = true;
+}
+
+WalkingManager::StopReport WalkingManager::get_stop_report()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return stop_report;
+}
+
+// The feet come together on the step after the one being stepped to, from the stop precomputed
+// for this support phase
+void WalkingManager::apply_stop()
+{
+  pending_command = NO_COMMAND;
+  queued_goals.clear();
+
+  // A replayed step can not follow a new plan, the rest of it is generated live
+  if (memo_mode == MEMO_REPLAY) {
+    leave_replay();
+  }
+
+  if (
+    !idle && foot_step_planner.apply_stop() && com_generator->get_remaining_samples() > 0) {
+    com_generator->update_steps(foot_step_planner.foot_steps, 2);
+
+    if (memo_mode == MEMO_RECORD) {
+      memo_mode = MEMO_NONE;
+    }
+  }
+
+  stop_start_time = stop_request_time;
+  stop_measuring = true;
+
+  // Standing idle is already the stopped motion
+  if (idle) {
+    measure_stop();
+  }
+}
+
+void WalkingManager::measure_stop()
+{
+  auto latency = std::chrono::steady_clock::duration(
+    std::chrono::steady_clock::now().time_since_epoch().count() - stop_start_time);
+
+  stop_report.latency = std::chrono::duration<double>(latency).count();
+  stop_report.max_latency = std::max(stop_report.max_latency, stop_report.latency);
+  stop_report.count++;
+
+  stop_measuring = false;
+}
 
 void WalkingManager::remove_steps()
 {
-  if (foot_step_planner.foot_steps.size() <= 4) {
+  // A plan that is still being extended always refills its window
+  if (foot_step_planner.foot_steps.size() <= 4 && foot_step_planner.is_complete()) {
     status = FootStepPlanner::START;
   }
 
   if (foot_step_planner.foot_steps.size() > 3) {
     foot_step_planner.foot_steps.pop_front();
+
+    // A changed velocity command rebuilds the steps after the one about to be stepped to, at most
+    // once per consumed step however often the command arrives
+    if (foot_step_planner.is_velocity_mode() && foot_step_planner.is_velocity_changed()) {
+      foot_step_planner.replan_velocity(2);
+    } else {
+      foot_step_planner.extend();
+    }
   }
 }
 
-bool WalkingManager::replan() { return lipm.get_com_trajectory().empty(); }
+bool WalkingManager::replan() { return com_generator->get_remaining_samples() == 0; }
 
 void WalkingManager::set_goal(
   const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation)
+{
+  {
+    std::lock_guard<std::mutex> search_lock(search_mutex);
+    if (foot_step_search.has_obstacles()) {
+      search_goal(goal_position, goal_orientation);
+      return;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  pending_position = goal_position;
+  pending_orientation = goal_orientation;
+  request_command(GOAL_COMMAND);
+}
+
+// Only the latest command is stored, remove_steps() applies a changed one once per step
+void WalkingManager::set_velocity(const keisan::Point2 & velocity, double angular_velocity)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  foot_step_planner.set_velocity(velocity, angular_velocity);
+
+  if (foot_step_planner.is_velocity_mode()) {
+    pending_command = NO_COMMAND;
+    return;
+  }
+
+  request_command(VELOCITY_COMMAND);
+}
+
+// Chained onto the goals before it when a plan that ends is running or waiting, otherwise the
+// same as set_goal() without the obstacle search
+void WalkingManager::queue_goal(
+  const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const auto & foot_steps = foot_step_planner.foot_steps;
+  bool stepping = !idle && !foot_step_planner.is_velocity_mode() && foot_steps.size() > 2 &&
+                  foot_steps[1].support_foot != FootStepPlanner::BOTH_FEET;
+
+  bool chaining = pending_command == NO_COMMAND ? stepping : pending_command != VELOCITY_COMMAND;
+  if (!chaining) {
+    pending_position = goal_position;
+    pending_orientation = goal_orientation;
+    request_command(GOAL_COMMAND);
+    return;
+  }
+
+  auto goal = FootStepPlanner::Pose();
+  goal.position = goal_position;
+  goal.orientation = goal_orientation;
+  queued_goals.push_back(goal);
+
+  // Otherwise they are handed over once the step ends
+  if (
+    pending_command == NO_COMMAND && com_generator->get_remaining_samples() > 0 &&
+    memo_mode != MEMO_REPLAY) {
+    flush_goals();
+  }
+}
+
+void WalkingManager::set_path(const std::vector<FootStepPlanner::Pose> & path)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  pending_poses = path;
+  request_command(PATH_COMMAND);
+}
+
+void WalkingManager::set_obstacles(
+  const std::vector<FootStepSearch::Circle> & circles,
+  const std::vector<FootStepSearch::Polygon> & polygons)
+{
+  std::lock_guard<std::mutex> search_lock(search_mutex);
+  foot_step_search.set_obstacles(circles, polygons);
+}
+
+std::unique_ptr<CenterOfMassGenerator> WalkingManager::clone_com_generator()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return com_generator->clone();
+}
+
+WalkingManager::MemoReport WalkingManager::get_memo_report()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto report = MemoReport();
+  report.hits = memo.get_hits();
+  report.misses = memo.get_misses();
+  report.entries = memo.size();
+
+  return report;
+}
+
+MPC::SolverReport WalkingManager::get_mpc_report()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return mpc ? mpc->get_solver_report() : MPC::SolverReport();
+}
+
+FootStepSearch::Report WalkingManager::get_search_report()
+{
+  std::lock_guard<std::mutex> search_lock(search_mutex);
+  return foot_step_search.get_report();
+}
+
+// The search does not hold up the walking loop, only its result is applied under the lock
+void WalkingManager::search_goal(
+  const keisan::Point2 & goal_position, const keisan::Angle<double> & goal_orientation)
+{
+  auto start = FootStepPlanner::Pose();
+  std::unique_ptr<FootStepPlanner> planner;
+  std::unique_ptr<CenterOfMassGenerator> generator;
+  int support = FootStepPlanner::RIGHT_FOOT;
+  int plan_status = FootStepPlanner::START;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    get_plan_start(start.position, start.orientation);
+
+    if (search_evaluator) {
+      planner = std::make_unique<FootStepPlanner>(foot_step_planner);
+      generator = com_generator->clone();
+      support = next_support;
+      plan_status = status;
+    }
+  }
+
+  auto goal = FootStepPlanner::Pose();
+  goal.position = goal_position;
+  goal.orientation = goal_orientation;
+
+  if (!foot_step_search.plan(start, goal, search_max_duration, search_poses)) {
+    std::cout << "No footstep plan around the obstacles within "
+              << search_max_duration * 1e3 << " ms, walking as close as the search got"
+              << std::endl;
+  }
+
+  const auto & poses = generator
+                        ? select_solution(*planner, *generator, start, support, plan_status)
+                        : search_poses;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  pending_poses = poses;
+  request_command(POSES_COMMAND);
+}
+
+// The plan with the fewest steps whose footsteps the COM model follows within the ZMP error
+// bound, or the one it follows best when none does, all from the current COM state
+const std::vector<FootStepPlanner::Pose> & WalkingManager::select_solution(
+  const FootStepPlanner & planner, const CenterOfMassGenerator & generator,
+  const FootStepPlanner::Pose & start, int support, int plan_status)
+{
+  const auto & solutions = foot_step_search.get_solutions();
+  if (solutions.size() < 2) {
+    return search_poses;
+  }
+
+  // Only the window the walking loop would materialize now, which bounds the cost of a candidate
+  std::vector<BatchEvaluator::FootSteps> candidates;
+  for (const auto & solution : solutions) {
+    auto candidate = planner;
+    candidate.plan_poses(solution, start.position, start.orientation, support, plan_status);
+    candidates.push_back(candidate.foot_steps);
+  }
+
+  auto evaluations = search_evaluator->evaluate(generator, candidates, generator.get_state());
+
+  size_t best = solutions.size() - 1;
+  for (size_t index = solutions.size(); index-- > 0;) {
+    if (evaluations[index].max_zmp_error <= search_max_zmp_error) {
+      return solutions[index];
+    }
+
+    if (evaluations[index].max_zmp_error < evaluations[best].max_zmp_error) {
+      best = index;
+    }
+  }
+
+  return solutions[best];
+}
+
+// Between steps the command is planned right away, mid-step the committed steps are kept
+void WalkingManager::request_command(int command)
+{
+  pending_command = NO_COMMAND;
+  queued_goals.clear();
+
+  if (com_generator->get_remaining_samples() == 0) {
+    plan_command(command);
+    return;
+  }
+
+  if (can_replan_tail()) {
+    replan_command(command);
+    return;
+  }
+
+  pending_command = command;
+}
+
+// A replayed step can not follow a new tail, and a stopping plan has no step left to keep
+bool WalkingManager::can_replan_tail() const
+{
+  const auto & foot_steps = foot_step_planner.foot_steps;
+
+  return status == FootStepPlanner::WALKING && memo_mode != MEMO_REPLAY &&
+         foot_steps.size() > 2 && foot_steps[1].support_foot != FootStepPlanner::BOTH_FEET;
+}
+
+void WalkingManager::plan_command(int command)
 {
   keisan::Point2 current_position = keisan::Point2(0.0, 0.0);
   keisan::Angle<double> current_orientation = 0.0_deg;
+  get_plan_start(current_position, current_orientation);
+
+  if (command == VELOCITY_COMMAND) {
+    foot_step_planner.plan_velocity(current_position, current_orientation, next_support, status);
+  } else if (command == POSES_COMMAND) {
+    foot_step_planner.plan_poses(
+      pending_poses, current_position, current_orientation, next_support, status);
+  } else if (command == PATH_COMMAND) {
+    foot_step_planner.plan_path(
+      pending_poses, current_position, current_orientation, next_support, status);
+  } else {
+    foot_step_planner.plan(
+      pending_position, pending_orientation, current_position, current_orientation, next_support,
+      status);
+  }
 
+  status = FootStepPlanner::WALKING;
+  idle = false;
+
+  update_time();
+}
+
+// A new plan starts from the body position of the step being stepped to
+void WalkingManager::get_plan_start(
+  keisan::Point2 & position, keisan::Angle<double> & orientation) const
+{
   if (foot_step_planner.foot_steps.size() > 2) {
     double y_offset = 0.0;
 
@@ -199,23 +908,70 @@ void WalkingManager::set_goal(
       y_offset = next_support == FootStepPlanner::LEFT_FOOT ? -step_y_offset : step_y_offset;
     }
 
-    current_position.x = foot_step_planner.foot_steps[1].position.x;
-    current_position.y = foot_step_planner.foot_steps[1].position.y + y_offset;
-    current_orientation = foot_step_planner.foot_steps[1].rotation;
+    position.x = foot_step_planner.foot_steps[1].position.x;
+    position.y = foot_step_planner.foot_steps[1].position.y + y_offset;
+    orientation = foot_step_planner.foot_steps[1].rotation;
   }
+}
+
+// The support step and the one being stepped to stay, so the current step is not restarted
+void WalkingManager::replan_command(int command)
+{
+  if (command == VELOCITY_COMMAND) {
+    foot_step_planner.replan_velocity(2);
+  } else if (command == POSES_COMMAND) {
+    foot_step_planner.replan_poses(pending_poses, 2);
+  } else if (command == PATH_COMMAND) {
+    foot_step_planner.replan_path(pending_poses, 2);
+  } else {
+    foot_step_planner.replan_tail(pending_position, pending_orientation, 2);
+  }
+
+  com_generator->update_steps(foot_step_planner.foot_steps, 2);
 
-  foot_step_planner.plan(
-    goal_position, goal_orientation, current_position, current_orientation, next_support, status);
+  // The samples recorded so far were keyed on the old footsteps
+  if (memo_mode == MEMO_RECORD) {
+    memo_mode = MEMO_NONE;
+  }
+}
+
+// The plan walks on to the queued goals instead of stopping, the committed steps stay
+void WalkingManager::flush_goals()
+{
+  if (queued_goals.empty()) {
+    return;
+  }
 
+  size_t first_changed = foot_step_planner.foot_steps.size();
+  for (const auto & goal : queued_goals) {
+    first_changed = std::min(first_changed, foot_step_planner.queue_goal(goal, 2));
+  }
+
+  queued_goals.clear();
   status = FootStepPlanner::WALKING;
 
-  update_time();
+  if (
+    com_generator->get_remaining_samples() > 0 &&
+    first_changed < foot_step_planner.foot_steps.size()) {
+    com_generator->update_steps(foot_step_planner.foot_steps, first_changed);
+
+    if (memo_mode == MEMO_RECORD) {
+      memo_mode = MEMO_NONE;
+    }
+  }
 }
 
 void WalkingManager::update_time()
 {
-  double time = foot_step_planner.foot_steps[0].time;
-  lipm.update(time, foot_step_planner.foot_steps);
+  update_com_target();
+
+  com_generator->begin(foot_step_planner.foot_steps[0].tick, foot_step_planner.foot_steps);
+  foot_step_planner.prepare_stop();
+
+  finish_memo();
+
+  height_offset_delta = (height_offset_target - height_offset) /
+                        std::max(com_generator->get_remaining_samples(), 1);
 
   if (foot_step_planner.foot_steps[0].support_foot == FootStepPlanner::LEFT_FOOT) {
     if (foot_step_planner.foot_steps[1].support_foot == FootStepPlanner::BOTH_FEET) {
@@ -250,12 +1006,36 @@ void WalkingManager::update_time()
   robot_orientation = foot_step_planner.foot_steps[0].rotation;
 }
 
-void WalkingManager::update_joints()
+void WalkingManager::update_pose()
 {
-  auto com = lipm.pop_front();
+  if (memo_mode == MEMO_REPLAY) {
+    replay_pose();
+    return;
+  }
 
-  double step_period = round(
-    (foot_step_planner.foot_steps[1].time - foot_step_planner.foot_steps[0].time) / time_step);
+  auto com = com_generator->advance(foot_step_planner.foot_steps);
+
+  int step_period = foot_step_planner.foot_steps[1].tick - foot_step_planner.foot_steps[0].tick;
+  pose_tick = foot_step_planner.foot_steps[1].tick - com_generator->get_remaining_samples();
+
+  auto segment = CenterOfMassGenerator::Segment();
+  if (segments_enabled && com_generator->get_segment(segment)) {
+    com_segments.append(segment);
+
+    if (memo_mode == MEMO_RECORD) {
+      segment.start_time -= foot_step_planner.foot_steps[0].tick * time_step;
+      segment.coefficients[0].x -= memo_origin.x;
+      segment.coefficients[0].y -= memo_origin.y;
+
+      // The same segment comes on every sample until a replan solves the rest of the step again
+      auto & segments = memo_entry.segments;
+      if (!segments.empty() && segments.back().start_time == segment.start_time) {
+        segments.back() = segment;
+      } else {
+        segments.push_back(segment);
+      }
+    }
+  }
 
   auto rotation =
     foot_step_planner.foot_steps[1].rotation - foot_step_planner.foot_steps[0].rotation;
@@ -263,12 +1043,12 @@ void WalkingManager::update_joints()
   robot_orientation += rotation;
 
   double ssp_start = round(dsp_duration / (2 * time_step));
-  double ssp_end = round(step_period / 2);
+  double ssp_end = round(step_period / 2.0);
   double ssp_duration = ssp_end - ssp_start;
 
   if (foot_step_planner.foot_steps[0].support_foot == FootStepPlanner::LEFT_FOOT) {
     // Raise or lower right foot
-    double diff = step_period - lipm.get_com_trajectory().size();
+    double diff = step_period - com_generator->get_remaining_samples();
     if (ssp_start < diff && diff <= ssp_end) {
       right_up += foot_height / ssp_duration;
     } else if (right_up > 0.0) {
@@ -285,7 +1065,7 @@ void WalkingManager::update_joints()
     }
   } else if (foot_step_planner.foot_steps[0].support_foot == FootStepPlanner::RIGHT_FOOT) {
     // Raise or lower left foot
-    double diff = step_period - lipm.get_com_trajectory().size();
+    double diff = step_period - com_generator->get_remaining_samples();
     if (ssp_start < diff && diff <= ssp_end) {
       left_up += foot_height / ssp_duration;
     } else if (left_up > 0.0) {
@@ -302,23 +1082,92 @@ void WalkingManager::update_joints()
     }
   }
 
+  // Leg height follows the COM height in a straight ramp over the step
+  height_offset += height_offset_delta;
+  if (com_generator->get_remaining_samples() == 0) {
+    height_offset = height_offset_target;
+  }
+
+  previous_pose = current_pose;
+
+  current_pose.com_position = com.position;
+  current_pose.com_velocity = com.velocity;
+  current_pose.left_offset = left_offset;
+  current_pose.right_offset = right_offset;
+  current_pose.left_up = left_up;
+  current_pose.right_up = right_up;
+  current_pose.height_offset = height_offset;
+  current_pose.orientation = robot_orientation;
+
+  // Nothing to interpolate from on the first sample
+  if (!initialized) {
+    previous_pose = current_pose;
+    initialized = true;
+  }
+
+  if (memo_mode == MEMO_RECORD) {
+    memo_entry.poses.push_back(
+      shift_pose(current_pose, keisan::Point2(-memo_origin.x, -memo_origin.y), -memo_rotation));
+    memo_entry.states.push_back(com_generator->to_local(com_generator->get_state(), memo_origin));
+  }
+}
+
+void WalkingManager::update_joints()
+{
+  // The last call of an interpolation window lands on the current LIPM sample
+  double fraction = interpolation_step == 0
+                      ? 1.0
+                      : static_cast<double>(interpolation_step) / interpolation_steps;
+
+  // COM follows a cubic Hermite through the LIPM samples, the feet already move in straight ramps
+  Pose pose;
+  double time = (pose_tick - 1 + fraction) * time_step;
+  if (!segments_enabled || !com_segments.get_position(time, pose.com_position)) {
+    pose.com_position = hermite(
+      previous_pose.com_position, previous_pose.com_velocity, current_pose.com_position,
+      current_pose.com_velocity, time_step, fraction);
+  }
+  pose.left_offset = previous_pose.left_offset * (1 - fraction) +
+                     current_pose.left_offset * fraction;
+  pose.right_offset = previous_pose.right_offset * (1 - fraction) +
+                      current_pose.right_offset * fraction;
+  pose.left_up = lerp(previous_pose.left_up, current_pose.left_up, fraction);
+  pose.right_up = lerp(previous_pose.right_up, current_pose.right_up, fraction);
+  pose.height_offset = lerp(previous_pose.height_offset, current_pose.height_offset, fraction);
+  pose.orientation = previous_pose.orientation * (1 - fraction) +
+                     current_pose.orientation * fraction;
+
   auto left_foot_pose = keisan::Matrix<1, 3>(
-    left_offset[0][0] - com.position.x, left_offset[0][1] - com.position.y, left_offset[0][2]);
+    pose.left_offset[0][0] - pose.com_position.x, pose.left_offset[0][1] - pose.com_position.y,
+    pose.left_offset[0][2]);
 
   auto right_foot_pose = keisan::Matrix<1, 3>(
-    right_offset[0][0] - com.position.x, right_offset[0][1] - com.position.y, right_offset[0][2]);
+    pose.right_offset[0][0] - pose.com_position.x, pose.right_offset[0][1] - pose.com_position.y,
+    pose.right_offset[0][2]);
 
   Kinematics::Foot left_foot;
   left_foot.position.x = left_foot_pose[0][0] + foot_offset.x;
   left_foot.position.y = left_foot_pose[0][1] + foot_offset.y;
-  left_foot.position.z = left_up + foot_offset.z;
-  left_foot.yaw = robot_orientation - keisan::make_radian(left_foot_pose[0][2]);
+  left_foot.position.z = pose.left_up + foot_offset.z + pose.height_offset;
+  left_foot.yaw = pose.orientation - keisan::make_radian(left_foot_pose[0][2]);
 
   Kinematics::Foot right_foot;
   right_foot.position.x = right_foot_pose[0][0] + foot_offset.x;
   right_foot.position.y = right_foot_pose[0][1] - foot_offset.y;
-  right_foot.position.z = right_up + foot_offset.z;
-  right_foot.yaw = robot_orientation - keisan::make_radian(right_foot_pose[0][2]);
+  right_foot.position.z = pose.right_up + foot_offset.z + pose.height_offset;
+  right_foot.yaw = pose.orientation - keisan::make_radian(right_foot_pose[0][2]);
+
+  if (memo_mode == MEMO_REPLAY && (memo_tick + 1) * joints.size() <= memo_replay->joints.size()) {
+    const double * positions = memo_replay->joints.data() + memo_tick * joints.size();
+    memo_tick++;
+
+    for (size_t i = 0; i < joints.size(); ++i) {
+      joints[i].set_position(positions[i]);
+    }
+
+    robot_position = pose.com_position + odometry_offset;
+    return;
+  }
 
   try {
     kinematics.solve_inverse_kinematics(left_foot, right_foot);
@@ -331,21 +1180,242 @@ void WalkingManager::update_joints()
       joint.set_position(angles[id].degree());
     }
 
-    robot_position = com.position + odometry_offset;
+    robot_position = pose.com_position + odometry_offset;
+
+    if (memo_mode == MEMO_RECORD) {
+      for (const auto & joint : joints) {
+        memo_entry.joints.push_back(joint.get_position());
+      }
+    }
   } catch (const std::exception & e) {
     std::cerr << "Failed to solve inverse kinematics!" << std::endl;
     std::cerr << e.what() << std::endl;
+
+    // A step with a failed solution is not worth replaying
+    if (memo_mode == MEMO_RECORD) {
+      memo_mode = MEMO_NONE;
+    }
   }
 }
 
 void WalkingManager::process()
 {
-  if (lipm.get_com_trajectory().empty() || status == FootStepPlanner::STOP) {
-    remove_steps();
-    update_time();
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (stop_requested) {
+    stop_requested = false;
+    apply_stop();
   }
 
+  // Hold the last COM and joint solution until a new goal arrives
+  if (idle) {
+    return;
+  }
+
+  // The LIPM and the feet advance once every interpolation window
+  if (interpolation_step == 0) {
+    if (com_generator->get_remaining_samples() == 0 || status == FootStepPlanner::STOP) {
+      if (pending_command != NO_COMMAND) {
+        int command = pending_command;
+        pending_command = NO_COMMAND;
+
+        plan_command(command);
+        flush_goals();
+      } else {
+        flush_goals();
+
+        if (is_standing()) {
+          idle = true;
+
+          if (stop_measuring) {
+            measure_stop();
+          }
+
+          return;
+        }
+
+        remove_steps();
+        update_time();
+      }
+
+      start_memo();
+    }
+
+    update_pose();
+
+    if (stop_measuring) {
+      measure_stop();
+    }
+  }
+
+  interpolation_step = (interpolation_step + 1) % interpolation_steps;
+
   update_joints();
 }
 
+// Steps started here line up with the interpolation window, so they can be recorded or replayed
+void WalkingManager::start_memo()
+{
+  if (!memo_enabled) {
+    return;
+  }
+
+  memo_origin = foot_step_planner.foot_steps[0].position;
+  memo_rotation = foot_step_planner.foot_steps[0].rotation.radian();
+  memo_key = get_memo_key();
+
+  memo_replay = memo.find(memo_key);
+  if (memo_replay) {
+    memo_mode = MEMO_REPLAY;
+  } else {
+    memo_mode = MEMO_RECORD;
+    memo_entry = MemoEntry();
+
+    size_t samples = com_generator->get_remaining_samples();
+    memo_entry.poses.reserve(samples);
+    memo_entry.states.reserve(samples);
+    memo_entry.joints.reserve(samples * interpolation_steps * joints.size());
+  }
+
+  memo_sample = 0;
+  memo_tick = 0;
+}
+
+// Store a completely recorded step together with the state the next step starts from
+void WalkingManager::finish_memo()
+{
+  if (memo_mode == MEMO_RECORD) {
+    size_t samples = memo_entry.poses.size();
+
+    if (
+      samples > 0 && memo_entry.joints.size() == samples * interpolation_steps * joints.size()) {
+      memo_entry.end_state = com_generator->to_local(com_generator->get_state(), memo_origin);
+
+      memo.insert(memo_key, std::move(memo_entry));
+    }
+  }
+
+  memo_mode = MEMO_NONE;
+  memo_replay = nullptr;
+}
+
+// The generator picks up from the state of the last replayed sample and the current footsteps
+void WalkingManager::leave_replay()
+{
+  if (memo_sample > 0 && com_generator->get_remaining_samples() > 0) {
+    com_generator->set_state(
+      com_generator->to_world(memo_replay->states[memo_sample - 1], memo_origin));
+    com_generator->update_steps(foot_step_planner.foot_steps, 2);
+  }
+
+  memo_mode = MEMO_NONE;
+  memo_replay = nullptr;
+}
+
+void WalkingManager::replay_pose()
+{
+  auto pose = shift_pose(memo_replay->poses[memo_sample++], memo_origin, memo_rotation);
+
+  auto com = CenterOfMassGenerator::COMTrajectory();
+  com.position = pose.com_position;
+  com.velocity = pose.com_velocity;
+
+  com_generator->skip_sample(com);
+
+  pose_tick = foot_step_planner.foot_steps[1].tick - com_generator->get_remaining_samples();
+
+  // The recorded segments cover the whole step
+  if (segments_enabled && memo_sample == 1) {
+    for (auto segment : memo_replay->segments) {
+      segment.start_time += foot_step_planner.foot_steps[0].tick * time_step;
+      segment.coefficients[0].x += memo_origin.x;
+      segment.coefficients[0].y += memo_origin.y;
+
+      com_segments.append(segment);
+    }
+  }
+
+  left_offset = pose.left_offset;
+  right_offset = pose.right_offset;
+  left_up = pose.left_up;
+  right_up = pose.right_up;
+  height_offset = pose.height_offset;
+  robot_orientation = pose.orientation;
+
+  previous_pose = current_pose;
+  current_pose = pose;
+
+  // Hand the LIPM the state it would have reached
+  if (com_generator->get_remaining_samples() == 0 || memo_sample == memo_replay->poses.size()) {
+    com_generator->set_state(com_generator->to_world(memo_replay->end_state, memo_origin));
+  }
+}
+
+// The step parameters relative to the support foot, which repeat exactly in a periodic gait, and
+// the state the step starts from, coarse enough that drift between periodic steps still hits
+MemoCache<WalkingManager::MemoEntry>::Key WalkingManager::get_memo_key() const
+{
+  MemoCache<MemoEntry>::Key key;
+
+  auto quantize = [&key](double value, double resolution) {
+    key.push_back(static_cast<int64_t>(std::llround(value / resolution)));
+  };
+
+  const auto & foot_steps = foot_step_planner.foot_steps;
+
+  key.push_back(com_generator_type);
+  key.push_back(com_generator->get_remaining_samples());
+  key.push_back(interpolation_steps);
+
+  // Duration, support foot, stride and rotation of the footsteps the generator looks at
+  size_t window_size = com_generator->get_window_size();
+  for (size_t index = 0; index <= window_size && index < foot_steps.size(); ++index) {
+    key.push_back(foot_steps[index].tick - foot_steps[0].tick);
+    key.push_back(foot_steps[index].support_foot);
+    quantize(foot_steps[index].position.x - memo_origin.x, memo_resolution);
+    quantize(foot_steps[index].position.y - memo_origin.y, memo_resolution);
+    quantize(foot_steps[index].rotation.radian() - memo_rotation, memo_resolution);
+  }
+
+  // Where the swinging foot starts from and the leg height the step ramps to
+  for (const auto * offset : {&left_offset, &right_offset}) {
+    quantize((*offset)[0][0] - memo_origin.x, memo_resolution);
+    quantize((*offset)[0][1] - memo_origin.y, memo_resolution);
+    quantize((*offset)[0][2] - memo_rotation, memo_resolution);
+  }
+
+  for (double value : {target_com_height, target_com_period, height_offset_target}) {
+    quantize(value, memo_resolution);
+  }
+
+  auto state = com_generator->to_local(com_generator->get_state(), memo_origin);
+  for (double value :
+       {state.position.x, state.position.y, state.velocity.x, state.velocity.y,
+        state.acceleration.x, state.acceleration.y, state.control.x, state.control.y,
+        height_offset, robot_orientation.radian() - memo_rotation}) {
+    quantize(value, memo_state_resolution);
+  }
+
+  return key;
+}
+
+WalkingManager::Pose WalkingManager::shift_pose(
+  const Pose & pose, const keisan::Point2 & origin, double rotation) const
+{
+  auto shifted = pose;
+
+  shifted.com_position.x += origin.x;
+  shifted.com_position.y += origin.y;
+
+  for (auto * offset : {&shifted.left_offset, &shifted.right_offset}) {
+    (*offset)[0][0] += origin.x;
+    (*offset)[0][1] += origin.y;
+    (*offset)[0][2] += rotation;
+  }
+
+  shifted.orientation += keisan::make_radian(rotation);
+
+  return shifted;
+}
+
 }  // namespace gankenkun
@@ -20,6 +20,9 @@
 
 #include "gankenkun/walking/node/walking_node.hpp"
 
+#include <cmath>
+#include <vector>
+
 #include "tachimawari/joint/utils/middleware.hpp"
 
 namespace gankenkun
@@ -27,7 +30,7 @@ namespace gankenkun
 
 WalkingNode::WalkingNode(
   const rclcpp::Node::SharedPtr & node, const std::shared_ptr<WalkingManager> & walking_manager)
-: node(node), walking_manager(walking_manager)
+: node(node), walking_manager(walking_manager), memo_steps(0), stop_count(0)
 {
   set_walking_group = node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
 
@@ -37,22 +40,130 @@ WalkingNode::WalkingNode(
   set_walking_subscriber = node->create_subscription<SetWalking>(
     "walking/set_walking", 10,
     [this](const SetWalking::SharedPtr message) {
-      while (true) {
-        if (this->walking_manager->replan()) {
-          if (message->run) {
-            this->walking_manager->set_goal(
-              keisan::Point2(message->position.x, message->position.y),
-              keisan::make_degree(message->orientation));
-          } else {
-            this->walking_manager->stop();
+      // The manager keeps the committed steps, or holds the goal until the step ends
+      if (message->run) {
+        this->walking_manager->set_goal(
+          keisan::Point2(message->position.x, message->position.y),
+          keisan::make_degree(message->orientation));
+      } else {
+        this->walking_manager->stop();
+      }
+    },
+    subscriber_option);
+
+  queue_goal_subscriber = node->create_subscription<SetWalking>(
+    "walking/queue_goal", 10,
+    [this](const SetWalking::SharedPtr message) {
+      if (message->run) {
+        this->walking_manager->queue_goal(
+          keisan::Point2(message->position.x, message->position.y),
+          keisan::make_degree(message->orientation));
+      } else {
+        this->walking_manager->stop();
+      }
+    },
+    subscriber_option);
+
+  set_velocity_subscriber = node->create_subscription<Twist>(
+    "walking/set_velocity", 10,
+    [this](const Twist::SharedPtr message) {
+      this->walking_manager->set_velocity(
+        keisan::Point2(message->linear.x, message->linear.y), message->angular.z);
+    },
+    subscriber_option);
+
+  set_path_subscriber = node->create_subscription<Path>(
+    "walking/set_path", 10,
+    [this](const Path::SharedPtr message) {
+      std::vector<FootStepPlanner::Pose> path;
+      for (const auto & stamped : message->poses) {
+        const auto & orientation = stamped.pose.orientation;
+
+        // Heading is the yaw of the quaternion
+        double yaw = std::atan2(
+          2.0 * (orientation.w * orientation.z + orientation.x * orientation.y),
+          1.0 - 2.0 * (orientation.y * orientation.y + orientation.z * orientation.z));
+
+        auto pose = FootStepPlanner::Pose();
+        pose.position = keisan::Point2(stamped.pose.position.x, stamped.pose.position.y);
+        pose.orientation = keisan::make_radian(yaw);
+        path.push_back(pose);
+      }
+
+      this->walking_manager->set_path(path);
+    },
+    subscriber_option);
+
+  // The x is the COM height and the y the preview period, applied from the gain bank when the
+  // next step starts
+  set_com_target_subscriber = node->create_subscription<Point2>(
+    "walking/set_com_target", 10,
+    [this](const Point2::SharedPtr message) {
+      if (!this->walking_manager->set_com_target(message->x, message->y)) {
+        RCLCPP_WARN(
+          this->node->get_logger(),
+          "COM height %.3f m and period %.3f s are not covered by the gain bank", message->x,
+          message->y);
+      }
+    },
+    subscriber_option);
+
+  // Every message replaces the obstacles, cylinders and spheres are circles of half their x scale
+  // and line strips are polygons, all in the frame of the goals
+  set_obstacles_subscriber = node->create_subscription<MarkerArray>(
+    "walking/set_obstacles", 10,
+    [this](const MarkerArray::SharedPtr message) {
+      std::vector<FootStepSearch::Circle> circles;
+      std::vector<FootStepSearch::Polygon> polygons;
+
+      for (const auto & marker : message->markers) {
+        if (marker.action != visualization_msgs::msg::Marker::ADD) {
+          continue;
+        }
+
+        const auto & pose = marker.pose;
+
+        double yaw = std::atan2(
+          2.0 * (pose.orientation.w * pose.orientation.z + pose.orientation.x * pose.orientation.y),
+          1.0 - 2.0 * (pose.orientation.y * pose.orientation.y +
+                       pose.orientation.z * pose.orientation.z));
+        double cos_yaw = std::cos(yaw);
+        double sin_yaw = std::sin(yaw);
+
+        if (
+          marker.type == visualization_msgs::msg::Marker::CYLINDER ||
+          marker.type == visualization_msgs::msg::Marker::SPHERE) {
+          auto circle = FootStepSearch::Circle();
+          circle.center = keisan::Point2(pose.position.x, pose.position.y);
+          circle.radius = marker.scale.x / 2.0;
+          circles.push_back(circle);
+        } else if (
+          marker.type == visualization_msgs::msg::Marker::LINE_STRIP && marker.points.size() >= 3) {
+          auto polygon = FootStepSearch::Polygon();
+          for (const auto & point : marker.points) {
+            polygon.vertices.push_back(keisan::Point2(
+              pose.position.x + cos_yaw * point.x - sin_yaw * point.y,
+              pose.position.y + sin_yaw * point.x + cos_yaw * point.y));
           }
 
-          return;
+          polygons.push_back(polygon);
         }
       }
+
+      this->walking_manager->set_obstacles(circles, polygons);
     },
     subscriber_option);
 
+  // Not queued behind the other commands, an obstacle search can hold those up
+  stop_group = node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+
+  auto stop_option = rclcpp::SubscriptionOptions();
+  stop_option.callback_group = stop_group;
+
+  stop_subscriber = node->create_subscription<Empty>(
+    "walking/stop", 10,
+    [this](const Empty::SharedPtr /* message */) { this->walking_manager->stop(); }, stop_option);
+
   set_odometry_subscriber = node->create_subscription<Point2>(
     "walking/set_odometry", 10, [this](const Point2::SharedPtr message) {
       // TODO: Set robot odometry
@@ -72,8 +183,72 @@ WalkingNode::WalkingNode(
 
 void WalkingNode::update()
 {
-  publish_joints();
+  // Joints do not change while standing idle
+  if (!walking_manager->is_idle()) {
+    publish_joints();
+  }
+
   publish_status();
+  log_mpc_report();
+  log_memo_report();
+  log_stop_report();
+}
+
+// Every tick at debug level, a solve cut short by its budget is warned about at most once a second
+void WalkingNode::log_mpc_report()
+{
+  auto report = walking_manager->get_mpc_report();
+  if (report.iterations == 0) {
+    return;
+  }
+
+  RCLCPP_DEBUG(
+    node->get_logger(), "MPC tick: %d iterations, %.3f ms, %d active constraints",
+    report.iterations, report.duration * 1e3, report.active_constraints);
+
+  if (!report.converged) {
+    RCLCPP_WARN_THROTTLE(
+      node->get_logger(), *node->get_clock(), 1000,
+      "MPC stopped before converging: %d iterations, %.3f ms, %d active constraints",
+      report.iterations, report.duration * 1e3, report.active_constraints);
+  }
+}
+
+// Only when a step started since the last report, at most once every ten seconds
+void WalkingNode::log_memo_report()
+{
+  auto report = walking_manager->get_memo_report();
+
+  size_t steps = report.hits + report.misses;
+  if (steps == memo_steps) {
+    return;
+  }
+
+  memo_steps = steps;
+
+  RCLCPP_DEBUG(
+    node->get_logger(), "Step memo: %zu hits, %zu misses, %zu entries", report.hits,
+    report.misses, report.entries);
+
+  RCLCPP_INFO_THROTTLE(
+    node->get_logger(), *node->get_clock(), 10000,
+    "Step memo hit rate %.1f%%: %zu hits, %zu misses, %zu entries",
+    steps > 0 ? 100.0 * report.hits / steps : 0.0, report.hits, report.misses, report.entries);
+}
+
+// Once per stop, from the command to the first sample of the stopping plan
+void WalkingNode::log_stop_report()
+{
+  auto report = walking_manager->get_stop_report();
+  if (report.count == stop_count) {
+    return;
+  }
+
+  stop_count = report.count;
+
+  RCLCPP_INFO(
+    node->get_logger(), "Stop reached the motion after %.3f ms, at most %.3f ms over %zu stops",
+    report.latency * 1e3, report.max_latency * 1e3, report.count);
 }
 
 void WalkingNode::publish_joints()
@@ -20,126 +20,570 @@
 
 #include "gankenkun/walking/planner/foot_step_planner.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace keisan::literals;
 
 namespace gankenkun
 {
 
 FootStepPlanner::FootStepPlanner()
-: period(0.0), width(0.0), max_stride(0.0, 0.0), max_rotation(0.0_deg)
+: max_stride(0.0, 0.0),
+  max_rotation(0.0_deg),
+  period(0.0),
+  width(0.0),
+  time_step(0.008),
+  window(0),
+  target_position(0.0, 0.0),
+  target_orientation(0.0_deg),
+  current_position(0.0, 0.0),
+  current_orientation(0.0_deg),
+  stride(0.0, 0.0),
+  stride_angle(0.0),
+  velocity(0.0, 0.0),
+  angular_velocity(0.0),
+  velocity_changed(false),
+  waypoint(0),
+  waypoint_steps(0),
+  next_support(LEFT_FOOT),
+  plan_status(START),
+  phase(COMPLETE_PHASE),
+  periods(0.0),
+  time(0.0),
+  tick(0)
 {
 }
 
 void FootStepPlanner::set_parameters(
   const keisan::Point2 & max_stride, const keisan::Angle<double> & max_rotation, double period,
-  double width)
+  double width, double time_step)
 {
   this->period = period;
   this->width = width;
+  this->time_step = time_step;
   this->max_stride = max_stride;
   this->max_rotation = max_rotation;
 }
 
+void FootStepPlanner::set_window(size_t window) { this->window = window; }
+
 void FootStepPlanner::plan(
   const keisan::Point2 & target_position, const keisan::Angle<double> & target_orientation,
   keisan::Point2 & current_position, keisan::Angle<double> & current_orientation, int next_support,
   int status)
 {
-  // Calculate the number of foot step
-  double time = 0.0;
+  this->target_position = target_position;
+  this->target_orientation = target_orientation;
+  plan_status = status;
+  phase = WALKING_PHASE;
 
-  double steps_x = std::abs((target_position.x - current_position.x) / max_stride.x);
-  double steps_y = std::abs((target_position.y - current_position.y) / max_stride.y);
-  double steps_angle =
-    std::abs(((target_orientation - current_orientation).radian()) / max_rotation.radian());
-  int max_steps = std::max(std::max(steps_x, steps_y), steps_angle);
+  start(current_position, current_orientation, next_support, status);
+  set_stride();
 
-  double stride_x = 0.0;
-  double stride_y = 0.0;
-  double stride_angle = 0.0;
+  extend();
 
-  if (max_steps > 0) {
-    stride_x = (target_position.x - current_position.x) / max_steps;
-    stride_y = (target_position.y - current_position.y) / max_steps;
-    stride_angle = (target_orientation - current_orientation).radian() / max_steps;
+  current_position = this->current_position;
+  current_orientation = this->current_orientation;
+}
+
+void FootStepPlanner::plan_velocity(
+  const keisan::Point2 & current_position, const keisan::Angle<double> & current_orientation,
+  int next_support, int status)
+{
+  plan_status = WALKING;
+  phase = VELOCITY_PHASE;
+  velocity_changed = false;
+
+  start(current_position, current_orientation, next_support, status);
+
+  extend();
+}
+
+void FootStepPlanner::plan_poses(
+  const std::vector<Pose> & poses, const keisan::Point2 & current_position,
+  const keisan::Angle<double> & current_orientation, int next_support, int status)
+{
+  plan_status = WALKING;
+  phase = PATH_PHASE;
+
+  start(current_position, current_orientation, next_support, status);
+  set_waypoints(poses);
+
+  extend();
+}
+
+void FootStepPlanner::plan_path(
+  const std::vector<Pose> & path, const keisan::Point2 & current_position,
+  const keisan::Angle<double> & current_orientation, int next_support, int status)
+{
+  plan_status = WALKING;
+  phase = PATH_PHASE;
+
+  start(current_position, current_orientation, next_support, status);
+  set_waypoints(resample_path(path));
+
+  extend();
+}
+
+void FootStepPlanner::replan_tail(
+  const keisan::Point2 & target_position, const keisan::Angle<double> & target_orientation,
+  size_t keep)
+{
+  this->target_position = target_position;
+  this->target_orientation = target_orientation;
+  plan_status = WALKING;
+  phase = WALKING_PHASE;
+
+  resume(keep);
+  set_stride();
+
+  extend();
+}
+
+void FootStepPlanner::replan_poses(const std::vector<Pose> & poses, size_t keep)
+{
+  plan_status = WALKING;
+  phase = PATH_PHASE;
+
+  resume(keep);
+  set_waypoints(poses);
+
+  extend();
+}
+
+void FootStepPlanner::replan_path(const std::vector<Pose> & path, size_t keep)
+{
+  plan_status = WALKING;
+  phase = PATH_PHASE;
+
+  resume(keep);
+  set_waypoints(resample_path(path));
+
+  extend();
+}
+
+void FootStepPlanner::replan_velocity(size_t keep)
+{
+  plan_status = WALKING;
+  phase = VELOCITY_PHASE;
+  velocity_changed = false;
+
+  resume(keep);
+
+  extend();
+}
+
+// Queued goals are walked to in turn, stepping onto each one without bringing the feet together
+size_t FootStepPlanner::queue_goal(const Pose & goal, size_t keep)
+{
+  if (phase != COMPLETE_PHASE) {
+    goals.push_back(goal);
+    return foot_steps.size();
   }
 
-  // Plan first foot step
-  foot_steps.clear();
-  if (status == START) {
-    foot_steps.push_back({0.0, current_position, current_orientation, BOTH_FEET});
-    time += period * 2;
+  // The stop at the target is already planned, continue from the step onto it instead
+  size_t index = foot_steps.size();
+  while (index > 0 && foot_steps[index - 1].support_foot == BOTH_FEET) {
+    index--;
   }
 
-  if (next_support == LEFT_FOOT) {
-    foot_steps.push_back(
-      {time, keisan::Point2(current_position.x, current_position.y + width), current_orientation,
-       LEFT_FOOT});
-    next_support = RIGHT_FOOT;
+  plan_status = WALKING;
+  phase = WALKING_PHASE;
+
+  resume(std::max(index, keep));
+
+  target_position = goal.position;
+  target_orientation = goal.orientation;
+  set_stride();
+
+  index = foot_steps.size();
+
+  extend();
+
+  return index;
+}
+
+// Only the latest command is kept, it shapes every step appended from now on
+void FootStepPlanner::set_velocity(const keisan::Point2 & velocity, double angular_velocity)
+{
+  velocity_changed |= velocity.x != this->velocity.x || velocity.y != this->velocity.y ||
+                      angular_velocity != this->angular_velocity;
+
+  this->velocity = velocity;
+  this->angular_velocity = angular_velocity;
+}
+
+// The other foot is put beside the step being stepped to, then both feet stay, as at a target
+void FootStepPlanner::prepare_stop()
+{
+  stop_steps.clear();
+
+  if (foot_steps.size() < 2 || foot_steps[1].support_foot == BOTH_FEET) {
+    return;
+  }
+
+  const auto & last = foot_steps[1];
+
+  auto position = last.position;
+  position.y += last.support_foot == LEFT_FOOT ? -width : width;
+
+  double stop_periods = std::round(last.time / period) + 1.0;
+  double stop_time = stop_periods * period;
+  if (last.support_foot == LEFT_FOOT) {
+    stop_steps.push_back(
+      {stop_time, static_cast<int>(std::lround(stop_time / time_step)),
+       keisan::Point2(position.x, position.y - width), last.rotation, RIGHT_FOOT});
   } else {
-    foot_steps.push_back(
-      {time, keisan::Point2(current_position.x, current_position.y - width), current_orientation,
-       RIGHT_FOOT});
-    next_support = LEFT_FOOT;
+    stop_steps.push_back(
+      {stop_time, static_cast<int>(std::lround(stop_time / time_step)),
+       keisan::Point2(position.x, position.y + width), last.rotation, LEFT_FOOT});
   }
 
-  // Plan walking foot steps
-  size_t counter = 0;
-  while (true) {
-    counter += 1;
+  stop_periods += 1.0;
+  stop_time = stop_periods * period;
+  stop_steps.push_back(
+    {stop_time, static_cast<int>(std::lround(stop_time / time_step)), position, last.rotation,
+     BOTH_FEET});
+
+  stop_periods += 2.0;
+  stop_time = stop_periods * period;
+  stop_steps.push_back(
+    {stop_time, static_cast<int>(std::lround(stop_time / time_step)), position, last.rotation,
+     BOTH_FEET});
+
+  // Far away step that only pads the preview window
+  stop_steps.push_back(
+    {stop_time + 100.0,
+     static_cast<int>(std::lround(stop_time / time_step)) +
+       static_cast<int>(std::lround(100.0 / time_step)),
+     position, last.rotation, BOTH_FEET});
+}
+
+// The plan ends as if the stop pose had been its target
+bool FootStepPlanner::apply_stop()
+{
+  if (stop_steps.empty() || foot_steps.size() < 2) {
+    return false;
+  }
+
+  foot_steps.resize(2);
+  foot_steps.insert(foot_steps.end(), stop_steps.begin(), stop_steps.end());
+
+  goals.clear();
+
+  target_position = stop_steps[1].position;
+  target_orientation = stop_steps[1].rotation;
+  current_position = target_position;
+  current_orientation = target_orientation;
+  next_support = BOTH_FEET;
+  plan_status = WALKING;
+  phase = COMPLETE_PHASE;
+
+  periods = std::round(stop_steps[2].time / period);
+  time = stop_steps.back().time;
+  tick = stop_steps.back().tick;
+
+  return true;
+}
+
+void FootStepPlanner::extend()
+{
+  // A velocity plan never completes, so it is always held at a window
+  size_t limit = phase == VELOCITY_PHASE ? std::max(window, MIN_VELOCITY_WINDOW) : window;
+
+  while ((limit == 0 || foot_steps.size() < limit) && add_step()) {
+  }
+}
+
+// Materialize the next step of the plan, false once the plan is complete
+bool FootStepPlanner::add_step()
+{
+  if (phase == COMPLETE_PHASE) {
+    return false;
+  }
+
+  // Turn first, then move along the new heading, both within the stride limits
+  if (phase == VELOCITY_PHASE) {
+    advance(1.0);
 
+    double turn = std::clamp(
+      angular_velocity * period, -max_rotation.radian(), max_rotation.radian());
+    current_orientation = current_orientation + keisan::make_radian(turn);
+
+    double forward = std::clamp(velocity.x * period, -max_stride.x, max_stride.x);
+    double lateral = std::clamp(velocity.y * period, -max_stride.y, max_stride.y);
+    double cos_angle = std::cos(current_orientation.radian());
+    double sin_angle = std::sin(current_orientation.radian());
+
+    current_position.x += cos_angle * forward - sin_angle * lateral;
+    current_position.y += sin_angle * forward + cos_angle * lateral;
+
+    add_support_step(current_position, current_orientation);
+
+    return true;
+  }
+
+  // Every waypoint is stepped on, the ones beyond a stride are reached in equal strides
+  if (phase == PATH_PHASE) {
+    while (waypoint < waypoints.size()) {
+      if (waypoint_steps == 0) {
+        target_position = waypoints[waypoint].position;
+        target_orientation = waypoints[waypoint].orientation;
+
+        double delta_angle = (target_orientation - current_orientation).radian();
+        double steps = std::max(
+          std::max(
+            std::abs(target_position.x - current_position.x) / max_stride.x,
+            std::abs(target_position.y - current_position.y) / max_stride.y),
+          std::abs(delta_angle) / max_rotation.radian());
+
+        waypoint_steps = static_cast<int>(std::ceil(steps - 1e-9));
+        if (waypoint_steps == 0) {
+          waypoint++;
+          continue;
+        }
+
+        stride.x = (target_position.x - current_position.x) / waypoint_steps;
+        stride.y = (target_position.y - current_position.y) / waypoint_steps;
+        stride_angle = delta_angle / waypoint_steps;
+      }
+
+      advance(1.0);
+
+      current_position = current_position + stride;
+      current_orientation = current_orientation + keisan::make_radian(stride_angle);
+
+      add_support_step(current_position, current_orientation);
+
+      if (--waypoint_steps == 0) {
+        waypoint++;
+      }
+
+      return true;
+    }
+  }
+
+  // Plan walking foot steps
+  if (phase == WALKING_PHASE) {
     double delta_x = std::abs(target_position.x - current_position.x);
     double delta_y = std::abs(target_position.y - current_position.y);
     double delta_angle = std::abs((target_orientation - current_orientation).radian());
 
-    if (delta_x < max_stride.x && delta_y < max_stride.y && delta_angle < max_rotation.radian()) {
-      break;
+    if (delta_x >= max_stride.x || delta_y >= max_stride.y || delta_angle >= max_rotation.radian()) {
+      advance(1.0);
+
+      current_position = current_position + stride;
+      current_orientation = current_orientation + keisan::make_radian(stride_angle);
+
+      add_support_step(current_position, current_orientation);
+
+      return true;
     }
 
-    time += period;
-
-    auto next_position = current_position + keisan::Point2(stride_x, stride_y);
-    auto next_orientation = current_orientation + keisan::make_radian(stride_angle);
-
-    if (next_support == LEFT_FOOT) {
-      foot_steps.push_back(
-        {time, keisan::Point2(next_position.x, next_position.y + width), next_orientation,
-         LEFT_FOOT});
-      next_support = RIGHT_FOOT;
-    } else {
-      foot_steps.push_back(
-        {time, keisan::Point2(next_position.x, next_position.y - width), next_orientation,
-         RIGHT_FOOT});
-      next_support = LEFT_FOOT;
+    if (plan_status == STOP) {
+      phase = COMPLETE_PHASE;
+      return false;
     }
+  }
+
+  // Step onto the target and carry on to the next queued goal
+  if (!goals.empty()) {
+    advance(1.0);
+    add_support_step(target_position, target_orientation);
+
+    current_position = target_position;
+    current_orientation = target_orientation;
 
-    current_position = next_position;
-    current_orientation = next_orientation;
+    target_position = goals.front().position;
+    target_orientation = goals.front().orientation;
+    goals.pop_front();
+
+    phase = WALKING_PHASE;
+    set_stride();
+
+    return true;
   }
 
   // Planning walk in position
-  if (status != STOP) {
-    time += period;
-
-    if (next_support == LEFT_FOOT) {
-      foot_steps.push_back(
-        {time, keisan::Point2(target_position.x, target_position.y + width), target_orientation,
-         LEFT_FOOT});
-    } else {
-      foot_steps.push_back(
-        {time, keisan::Point2(target_position.x, target_position.y - width), target_orientation,
-         RIGHT_FOOT});
+  phase = COMPLETE_PHASE;
+
+  advance(1.0);
+  add_support_step(target_position, target_orientation);
+
+  advance(1.0);
+  next_support = BOTH_FEET;
+  foot_steps.push_back({time, tick, target_position, target_orientation, BOTH_FEET});
+
+  advance(2.0);
+  foot_steps.push_back({time, tick, target_position, target_orientation, BOTH_FEET});
+
+  // Far away step that only pads the preview window
+  time += 100.0;
+  tick += static_cast<int>(std::lround(100.0 / time_step));
+  foot_steps.push_back({time, tick, target_position, target_orientation, BOTH_FEET});
+
+  return true;
+}
+
+// Reset the step clock and place the first steps of a new plan
+void FootStepPlanner::start(
+  const keisan::Point2 & current_position, const keisan::Angle<double> & current_orientation,
+  int next_support, int status)
+{
+  this->current_position = current_position;
+  this->current_orientation = current_orientation;
+  this->next_support = next_support;
+
+  goals.clear();
+
+  // Step times are counted in whole periods and turned into ticks once, so nothing accumulates
+  periods = 0.0;
+  time = 0.0;
+  tick = 0;
+
+  // Plan first foot step
+  foot_steps.clear();
+  if (status == START) {
+    foot_steps.push_back({0.0, 0, current_position, current_orientation, BOTH_FEET});
+    advance(2.0);
+  }
+
+  add_support_step(current_position, current_orientation);
+}
+
+// Drop the steps after the kept ones and continue as if the last kept one was the first support
+void FootStepPlanner::resume(size_t keep)
+{
+  keep = std::max(keep, static_cast<size_t>(1));
+  if (foot_steps.size() > keep) {
+    foot_steps.resize(keep);
+  }
+
+  goals.clear();
+
+  const auto & last = foot_steps.back();
+
+  current_position = last.position;
+  current_position.y += last.support_foot == LEFT_FOOT    ? -width
+                        : last.support_foot == RIGHT_FOOT ? width
+                                                          : 0.0;
+  current_orientation = last.rotation;
+  next_support = last.support_foot == LEFT_FOOT ? RIGHT_FOOT : LEFT_FOOT;
+
+  periods = std::round(last.time / period);
+  time = last.time;
+  tick = last.tick;
+}
+
+// The last waypoint is where the plan stops, without any the plan stops where it is
+void FootStepPlanner::set_waypoints(const std::vector<Pose> & poses)
+{
+  waypoints = poses;
+  if (waypoints.empty()) {
+    waypoints.push_back({current_position, current_orientation});
+  }
+
+  waypoint = 0;
+  waypoint_steps = 0;
+
+  target_position = waypoints.back().position;
+  target_orientation = waypoints.back().orientation;
+}
+
+// Walk the polyline from the current pose in whole steps, a step that reaches a vertex carries
+// on along the next segment so the corners do not cost extra steps
+std::vector<FootStepPlanner::Pose> FootStepPlanner::resample_path(
+  const std::vector<Pose> & path) const
+{
+  std::vector<Pose> poses;
+
+  auto from = Pose();
+  from.position = current_position;
+  from.orientation = current_orientation;
+
+  // Part of a step, in strides, left for the next segment
+  double budget = 1.0;
+
+  for (const auto & vertex : path) {
+    double delta_x = vertex.position.x - from.position.x;
+    double delta_y = vertex.position.y - from.position.y;
+    double turn = std::remainder((vertex.orientation - from.orientation).radian(), 2.0 * M_PI);
+
+    // Strides the whole segment takes along its most limiting axis
+    double cost = std::max(
+      std::max(std::abs(delta_x) / max_stride.x, std::abs(delta_y) / max_stride.y),
+      std::abs(turn) / max_rotation.radian());
+    if (cost < 1e-9) {
+      continue;
+    }
+
+    double fraction = 0.0;
+    while (fraction + budget / cost < 1.0 - 1e-9) {
+      fraction += budget / cost;
+      budget = 1.0;
+
+      auto pose = Pose();
+      pose.position.x = from.position.x + delta_x * fraction;
+      pose.position.y = from.position.y + delta_y * fraction;
+      pose.orientation = from.orientation + keisan::make_radian(turn * fraction);
+      poses.push_back(pose);
     }
 
-    time += period;
-    next_support = BOTH_FEET;
-    foot_steps.push_back({time, target_position, target_orientation, BOTH_FEET});
+    budget -= (1.0 - fraction) * cost;
+
+    from.position = vertex.position;
+    from.orientation = from.orientation + keisan::make_radian(turn);
+  }
+
+  // The last vertex ends the path
+  if (!path.empty()) {
+    poses.push_back(from);
+  }
+
+  return poses;
+}
+
+// Split the way to the target into equal strides within the limits
+void FootStepPlanner::set_stride()
+{
+  // Calculate the number of foot step
+
+  double steps_x = std::abs((target_position.x - current_position.x) / max_stride.x);
+  double steps_y = std::abs((target_position.y - current_position.y) / max_stride.y);
+  double steps_angle =
+    std::abs(((target_orientation - current_orientation).radian()) / max_rotation.radian());
+  int max_steps = std::max(std::max(steps_x, steps_y), steps_angle);
+
+  stride = keisan::Point2(0.0, 0.0);
+  stride_angle = 0.0;
+
+  if (max_steps > 0) {
+    stride.x = (target_position.x - current_position.x) / max_steps;
+    stride.y = (target_position.y - current_position.y) / max_steps;
+    stride_angle = (target_orientation - current_orientation).radian() / max_steps;
+  }
+}
 
-    time += 2.0 * period;
-    foot_steps.push_back({time, target_position, target_orientation, BOTH_FEET});
+void FootStepPlanner::advance(double count)
+{
+  periods += count;
+  time = periods * period;
+  tick = static_cast<int>(std::lround(time / time_step));
+}
 
-    time += 100.0;
-    foot_steps.push_back({time, target_position, target_orientation, BOTH_FEET});
+// Put the next support foot beside the given body position and swap the support side
+void FootStepPlanner::add_support_step(
+  const keisan::Point2 & position, const keisan::Angle<double> & orientation)
+{
+  if (next_support == LEFT_FOOT) {
+    foot_steps.push_back(
+      {time, tick, keisan::Point2(position.x, position.y + width), orientation, LEFT_FOOT});
+    next_support = RIGHT_FOOT;
+  } else {
+    foot_steps.push_back(
+      {time, tick, keisan::Point2(position.x, position.y - width), orientation, RIGHT_FOOT});
+    next_support = LEFT_FOOT;
   }
 }
 
@@ -151,7 +595,8 @@ void FootStepPlanner::print_foot_steps()
                           : step.support_foot == LEFT_FOOT ? "left"
                                                            : "both";
 
-    std::cout << "Step " << counter++ << "-> Time(" << step.time << "); Position("
+    std::cout << "Step " << counter++ << "-> Time(" << step.time << "); Tick(" << step.tick
+              << "); Position("
               << step.position.x << ", " << step.position.y << "); Rotation("
               << step.rotation.radian() << "); "
               << "Support(\'" << support << "\')\n";
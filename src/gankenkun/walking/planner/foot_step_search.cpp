@@ -0,0 +1,418 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "gankenkun/walking/planner/foot_step_search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace gankenkun
+{
+
+FootStepSearch::FootStepSearch()
+: max_stride(0.0, 0.0),
+  max_rotation(keisan::make_radian(0.0)),
+  clearance(0.1),
+  initial_weight(3.0),
+  weight_step(0.5),
+  max_nodes(50000),
+  spacing(0.0, 0.0),
+  headings(0),
+  goal_node(-1),
+  goal_cost(std::numeric_limits<double>::infinity()),
+  closest_node(-1)
+{
+}
+
+void FootStepSearch::set_parameters(
+  const keisan::Point2 & max_stride, const keisan::Angle<double> & max_rotation, double clearance)
+{
+  this->max_stride = max_stride;
+  this->max_rotation = max_rotation;
+  this->clearance = clearance;
+
+  spacing = keisan::Point2(max_stride.x / 2.0, max_stride.y);
+
+  // Headings wrap around when whole rotations make up a turn
+  double turns = 2.0 * M_PI / max_rotation.radian();
+  headings = std::abs(turns - std::round(turns)) < 1e-6 ? static_cast<int>(std::round(turns)) : 0;
+
+  // Every step stays within one stride along each axis and one rotation
+  actions.clear();
+  for (int x = -2; x <= 2; ++x) {
+    for (int y = -1; y <= 1; ++y) {
+      for (int angle = -1; angle <= 1; ++angle) {
+        if (x != 0 || y != 0 || angle != 0) {
+          actions.push_back({x, y, angle});
+        }
+      }
+    }
+  }
+}
+
+void FootStepSearch::set_weights(double initial_weight, double weight_step)
+{
+  this->initial_weight = std::max(initial_weight, 1.0);
+  this->weight_step = weight_step;
+}
+
+void FootStepSearch::set_obstacles(
+  const std::vector<Circle> & circles, const std::vector<Polygon> & polygons)
+{
+  this->circles = circles;
+  this->polygons = polygons;
+}
+
+bool FootStepSearch::is_free(const keisan::Point2 & position) const
+{
+  for (const auto & circle : circles) {
+    double distance =
+      std::hypot(position.x - circle.center.x, position.y - circle.center.y);
+    if (distance < circle.radius + clearance) {
+      return false;
+    }
+  }
+
+  for (const auto & polygon : polygons) {
+    const auto & vertices = polygon.vertices;
+
+    bool inside = false;
+    for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+      const auto & a = vertices[i];
+      const auto & b = vertices[j];
+
+      // Crossings of a ray along x tell whether the position is inside
+      if ((a.y > position.y) != (b.y > position.y)) {
+        double x = a.x + (b.x - a.x) * (position.y - a.y) / (b.y - a.y);
+        if (position.x < x) {
+          inside = !inside;
+        }
+      }
+
+      double edge_x = b.x - a.x;
+      double edge_y = b.y - a.y;
+      double length = edge_x * edge_x + edge_y * edge_y;
+
+      double t = 0.0;
+      if (length > 0.0) {
+        t = ((position.x - a.x) * edge_x + (position.y - a.y) * edge_y) / length;
+        t = std::clamp(t, 0.0, 1.0);
+      }
+
+      double distance = std::hypot(a.x + edge_x * t - position.x, a.y + edge_y * t - position.y);
+      if (distance < clearance) {
+        return false;
+      }
+    }
+
+    if (inside) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool FootStepSearch::plan(
+  const Pose & start, const Pose & goal, double max_duration, std::vector<Pose> & poses)
+{
+  auto start_time = std::chrono::steady_clock::now();
+  auto deadline = max_duration > 0.0
+                    ? start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>(max_duration))
+                    : std::chrono::steady_clock::time_point::max();
+
+  report = Report();
+
+  this->start = start;
+  this->goal = goal;
+
+  nodes.clear();
+  lattice.clear();
+  heap.clear();
+
+  nodes.reserve(max_nodes);
+  lattice.reserve(max_nodes);
+  goal_node = -1;
+  goal_cost = std::numeric_limits<double>::infinity();
+
+  int origin = get_node(0, 0, 0);
+  nodes[origin].g = 0.0;
+  closest_node = origin;
+
+  if (is_within_step(start, goal) && is_free(start, goal)) {
+    goal_node = origin;
+    goal_cost = 1.0;
+  }
+
+  double weight = initial_weight;
+  report.weight = weight;
+
+  push(origin, weight);
+
+  solutions.clear();
+  double solution_cost = std::numeric_limits<double>::infinity();
+
+  // Each pass proves the plan within the weight, the next one reuses what is already expanded
+  while (improve_path(weight, deadline)) {
+    report.iterations++;
+    report.weight = weight;
+
+    // Later passes may reparent the nodes, so a pass that found a shorter plan traces it now
+    if (goal_node >= 0 && goal_cost < solution_cost) {
+      solutions.emplace_back();
+      trace_goal(solutions.back());
+      solution_cost = goal_cost;
+    }
+
+    if (weight <= 1.0 || goal_node < 0) {
+      break;
+    }
+
+    weight = weight_step > 0.0 ? std::max(weight - weight_step, 1.0) : 1.0;
+
+    heap.clear();
+    for (size_t index = 0; index < nodes.size(); ++index) {
+      auto & node = nodes[index];
+
+      if (node.inconsistent) {
+        node.inconsistent = false;
+        node.open = true;
+      }
+
+      node.closed = false;
+
+      if (node.open) {
+        heap.push_back({node.g + weight * node.h, node.g, static_cast<int>(index)});
+      }
+    }
+
+    std::make_heap(heap.begin(), heap.end(), std::greater<Entry>());
+  }
+
+  poses.clear();
+
+  report.found = goal_node >= 0;
+  if (report.found) {
+    trace_goal(poses);
+
+    // A pass cut short by the deadline may still have shortened the plan
+    if (goal_cost < solution_cost) {
+      solutions.push_back(poses);
+    }
+  } else {
+    trace(closest_node, poses);
+  }
+
+  report.duration =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+  return report.found;
+}
+
+FootStepSearch::Pose FootStepSearch::get_pose(const Node & node) const
+{
+  auto pose = Pose();
+
+  pose.position.x = start.position.x + node.x * spacing.x;
+  pose.position.y = start.position.y + node.y * spacing.y;
+  pose.orientation = start.orientation + keisan::make_radian(node.angle * max_rotation.radian());
+
+  return pose;
+}
+
+// Find the node of a lattice point or add it, -1 once the node limit is reached
+int FootStepSearch::get_node(int x, int y, int angle)
+{
+  if (headings > 0) {
+    angle = ((angle % headings) + headings) % headings;
+    if (angle > headings / 2) {
+      angle -= headings;
+    }
+  }
+
+  uint64_t key = (static_cast<uint64_t>(x & 0xFFFFF) << 40) |
+                 (static_cast<uint64_t>(y & 0xFFFFF) << 20) |
+                 static_cast<uint64_t>(angle & 0xFFFFF);
+
+  auto found = lattice.find(static_cast<int64_t>(key));
+  if (found != lattice.end()) {
+    return found->second;
+  }
+
+  if (nodes.size() >= max_nodes) {
+    return -1;
+  }
+
+  auto node = Node();
+  node.x = x;
+  node.y = y;
+  node.angle = angle;
+  node.g = std::numeric_limits<double>::infinity();
+  node.h = get_heuristic(get_pose(node));
+  node.parent = -1;
+  node.open = false;
+  node.closed = false;
+  node.inconsistent = false;
+
+  int index = static_cast<int>(nodes.size());
+  nodes.push_back(node);
+  lattice.emplace(static_cast<int64_t>(key), index);
+
+  return index;
+}
+
+// Steps left to the goal when every axis could move a whole stride at once
+double FootStepSearch::get_heuristic(const Pose & pose) const
+{
+  double turn = std::remainder((goal.orientation - pose.orientation).radian(), 2.0 * M_PI);
+
+  return std::max(
+    std::max(
+      std::abs(goal.position.x - pose.position.x) / max_stride.x,
+      std::abs(goal.position.y - pose.position.y) / max_stride.y),
+    std::abs(turn) / max_rotation.radian());
+}
+
+// The body passes the middle of a step as well as its end
+bool FootStepSearch::is_free(const Pose & from, const Pose & to) const
+{
+  auto middle = keisan::Point2(
+    (from.position.x + to.position.x) / 2.0, (from.position.y + to.position.y) / 2.0);
+
+  return is_free(to.position) && is_free(middle);
+}
+
+bool FootStepSearch::is_within_step(const Pose & from, const Pose & to) const
+{
+  double turn = std::remainder((to.orientation - from.orientation).radian(), 2.0 * M_PI);
+
+  return std::abs(to.position.x - from.position.x) <= max_stride.x + 1e-9 &&
+         std::abs(to.position.y - from.position.y) <= max_stride.y + 1e-9 &&
+         std::abs(turn) <= max_rotation.radian() + 1e-9;
+}
+
+void FootStepSearch::push(int node, double weight)
+{
+  nodes[node].open = true;
+
+  heap.push_back({nodes[node].g + weight * nodes[node].h, nodes[node].g, node});
+  std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+}
+
+// Expand until no open node can improve on the goal, false when the deadline came first
+bool FootStepSearch::improve_path(
+  double weight, const std::chrono::steady_clock::time_point & deadline)
+{
+  while (!heap.empty() && heap.front().key < goal_cost) {
+    auto entry = heap.front();
+    std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    heap.pop_back();
+
+    // Entries pushed before the node improved again are stale
+    int index = entry.node;
+    if (!nodes[index].open || entry.g != nodes[index].g) {
+      continue;
+    }
+
+    nodes[index].open = false;
+    nodes[index].closed = true;
+
+    report.expansions++;
+    if ((report.expansions & 31) == 0 && std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+
+    auto pose = get_pose(nodes[index]);
+
+    for (const auto & action : actions) {
+      int successor = get_node(
+        nodes[index].x + action.x, nodes[index].y + action.y, nodes[index].angle + action.angle);
+      if (successor < 0) {
+        continue;
+      }
+
+      double g = nodes[index].g + 1.0 + TURN_COST * std::abs(action.angle);
+      if (g >= nodes[successor].g) {
+        continue;
+      }
+
+      auto successor_pose = get_pose(nodes[successor]);
+      if (!is_free(pose, successor_pose)) {
+        continue;
+      }
+
+      nodes[successor].g = g;
+      nodes[successor].parent = index;
+
+      // The goal is one more step from any pose within a step of it
+      if (
+        g + 1.0 < goal_cost && is_within_step(successor_pose, goal) &&
+        is_free(successor_pose, goal)) {
+        goal_node = successor;
+        goal_cost = g + 1.0;
+      }
+
+      if (nodes[successor].h < nodes[closest_node].h) {
+        closest_node = successor;
+      }
+
+      if (!nodes[successor].closed) {
+        push(successor, weight);
+      } else {
+        nodes[successor].inconsistent = true;
+      }
+    }
+  }
+
+  return true;
+}
+
+// Poses to the goal node, then into the goal orientation the short way
+void FootStepSearch::trace_goal(std::vector<Pose> & poses) const
+{
+  trace(goal_node, poses);
+
+  auto last = poses.empty() ? start : poses.back();
+  double turn = std::remainder((goal.orientation - last.orientation).radian(), 2.0 * M_PI);
+  poses.push_back({goal.position, last.orientation + keisan::make_radian(turn)});
+}
+
+// Poses along the parents of the node, without the start
+void FootStepSearch::trace(int node, std::vector<Pose> & poses) const
+{
+  for (int index = node; index >= 0 && nodes[index].parent >= 0; index = nodes[index].parent) {
+    poses.push_back(get_pose(nodes[index]));
+  }
+
+  std::reverse(poses.begin(), poses.end());
+
+  // Wrapped headings are unwrapped again so every step turns the short way
+  auto orientation = start.orientation;
+  for (auto & pose : poses) {
+    double turn = std::remainder((pose.orientation - orientation).radian(), 2.0 * M_PI);
+    pose.orientation = orientation + keisan::make_radian(turn);
+    orientation = pose.orientation;
+  }
+}
+
+}  // namespace gankenkun
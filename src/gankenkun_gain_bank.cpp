@@ -0,0 +1,101 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "gankenkun/gankenkun.hpp"
+#include "jitsuyo/config.hpp"
+
+// Solve the LIPM gains over the grid in the `gain_bank` section of walking.json
+int main(int argc, char * argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Missing config path!" << std::endl;
+
+    return 0;
+  }
+
+  const std::string path = argv[1];
+
+  std::ifstream walking_file(path + "walking.json");
+  nlohmann::json walking_data = nlohmann::json::parse(walking_file);
+
+  double time_step = 0.008;
+  double preview_threshold = 0.0;
+  int dare_solver = gankenkun::LIPM::DOUBLING_SOLVER;
+  int dare_max_iterations = 1000;
+  double dare_max_duration = 0.0;
+  std::vector<double> com_heights;
+  std::vector<double> com_periods;
+
+  nlohmann::json timing_section;
+  if (jitsuyo::assign_val(walking_data, "timing", timing_section)) {
+    jitsuyo::assign_val(timing_section, "time_step", time_step);
+  }
+
+  // The DARE is solved with the same settings the walking node uses
+  nlohmann::json lipm_section;
+  if (jitsuyo::assign_val(walking_data, "lipm", lipm_section)) {
+    std::string solver = "doubling";
+
+    jitsuyo::assign_val(lipm_section, "solver", solver);
+    jitsuyo::assign_val(lipm_section, "max_iterations", dare_max_iterations);
+    jitsuyo::assign_val(lipm_section, "max_duration", dare_max_duration);
+    jitsuyo::assign_val(lipm_section, "preview_threshold", preview_threshold);
+
+    if (solver == "iterative") {
+      dare_solver = gankenkun::LIPM::ITERATIVE_SOLVER;
+    } else if (solver != "doubling") {
+      std::cerr << "Error found at section `lipm`" << std::endl;
+
+      return 1;
+    }
+  }
+
+  nlohmann::json gain_bank_section;
+  bool valid_section = jitsuyo::assign_val(walking_data, "gain_bank", gain_bank_section);
+  if (valid_section) {
+    valid_section &= jitsuyo::assign_val(gain_bank_section, "com_heights", com_heights);
+    valid_section &= jitsuyo::assign_val(gain_bank_section, "com_periods", com_periods);
+  }
+
+  if (!valid_section || com_heights.empty() || com_periods.empty()) {
+    std::cerr << "Error found at section `gain_bank`" << std::endl;
+
+    return 1;
+  }
+
+  gankenkun::GainBank gain_bank;
+  gain_bank.set_solver(dare_solver, dare_max_iterations, dare_max_duration);
+  gain_bank.generate(time_step, com_heights, com_periods, preview_threshold);
+
+  if (!gain_bank.save(path + "lipm_gain_bank.json")) {
+    return 1;
+  }
+
+  std::cout << "Gain bank of " << com_heights.size() << " COM heights and " << com_periods.size()
+            << " periods saved to `" << path << "lipm_gain_bank.json`" << std::endl;
+
+  return 0;
+}
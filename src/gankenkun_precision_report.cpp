@@ -0,0 +1,128 @@
+// Copyright (c) 2025 ICHIRO ITS
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "gankenkun/gankenkun.hpp"
+
+using namespace keisan::literals;
+
+// Walk the same goals with the double and single precision paths and report how far they drift apart
+int main(int argc, char * argv[])
+{
+  if (argc < 2) {
+    std::cerr << "Missing config path!" << std::endl;
+
+    return 0;
+  }
+
+  const std::string path = argv[1];
+
+  std::ifstream walking_file(path + "walking.json");
+  nlohmann::json walking_data = nlohmann::json::parse(walking_file);
+
+  std::ifstream kinematic_file(path + "kinematic.json");
+  nlohmann::json kinematic_data = nlohmann::json::parse(kinematic_file);
+
+  auto double_data = walking_data;
+  double_data["precision"] = {{"lipm", "double"}, {"kinematics", "double"}};
+
+  auto single_data = walking_data;
+  single_data["precision"] = {{"lipm", "single"}, {"kinematics", "single"}};
+
+  gankenkun::WalkingManager double_manager;
+  double_manager.set_config(double_data, kinematic_data);
+  double_manager.set_goal(keisan::Point2(0.0, 0.0), 0.0_deg);
+
+  gankenkun::WalkingManager single_manager;
+  single_manager.set_config(single_data, kinematic_data);
+  single_manager.set_goal(keisan::Point2(0.0, 0.0), 0.0_deg);
+
+  struct Goal
+  {
+    keisan::Point2 position;
+    keisan::Angle<double> orientation;
+  };
+
+  std::vector<Goal> goals = {
+    {keisan::Point2(0.5, 0.0), 0.0_deg},   {keisan::Point2(0.5, 0.2), 0.0_deg},
+    {keisan::Point2(0.5, 0.2), 90.0_deg},  {keisan::Point2(0.0, 0.0), -45.0_deg},
+    {keisan::Point2(0.0, 0.0), 0.0_deg},
+  };
+
+  double max_position_error = 0.0;
+  double sum_position_error = 0.0;
+  double max_joint_error = 0.0;
+  double sum_joint_error = 0.0;
+  size_t samples = 0;
+  size_t joint_samples = 0;
+
+  for (const auto & goal : goals) {
+    double_manager.set_goal(goal.position, goal.orientation);
+    single_manager.set_goal(goal.position, goal.orientation);
+
+    for (int tick = 0; tick < 10000 && !double_manager.is_idle(); ++tick) {
+      double_manager.process();
+      single_manager.process();
+
+      double position_error =
+        std::hypot(
+          double_manager.get_position().x - single_manager.get_position().x,
+          double_manager.get_position().y - single_manager.get_position().y);
+
+      max_position_error = std::max(max_position_error, position_error);
+      sum_position_error += position_error * position_error;
+      samples++;
+
+      const auto & double_joints = double_manager.get_joints();
+      const auto & single_joints = single_manager.get_joints();
+
+      for (size_t i = 0; i < double_joints.size(); ++i) {
+        double joint_error =
+          std::abs(double_joints[i].get_position() - single_joints[i].get_position());
+
+        max_joint_error = std::max(max_joint_error, joint_error);
+        sum_joint_error += joint_error * joint_error;
+        joint_samples++;
+      }
+    }
+  }
+
+  std::cout << "Compared " << samples << " samples over " << goals.size() << " goals" << std::endl;
+  std::cout << "COM position error: max " << max_position_error << " m, rms "
+            << std::sqrt(sum_position_error / std::max<size_t>(samples, 1)) << " m" << std::endl;
+  std::cout << "Joint angle error: max " << max_joint_error << " deg, rms "
+            << std::sqrt(sum_joint_error / std::max<size_t>(joint_samples, 1)) << " deg"
+            << std::endl;
+
+  // One step of a 4096 position servo
+  const double servo_resolution = 360.0 / 4096.0;
+  std::cout << "Servo resolution: " << servo_resolution << " deg, single precision is "
+            << (max_joint_error < servo_resolution ? "within" : "NOT within") << " resolution"
+            << std::endl;
+
+  return 0;
+}